@@ -1,4 +1,22 @@
 #include "ChainOfResponsibility.h"
+#include "ImageKernels.h"
+#include "../../Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 
 namespace cor_pattern {
@@ -8,21 +26,72 @@ namespace cor_pattern {
 		std::shared_ptr<Filter> m_next;
 	public:
 		std::shared_ptr<Filter> set_next(std::shared_ptr<Filter> next_filter) { m_next = next_filter; return m_next; }
-		virtual std::string process(std::string data) {
-			if (m_next) m_next->process(data);
-			return data;
+		std::shared_ptr<Filter> get_next() const { return m_next; }
+
+		std::string process(std::string data) {
+			std::string result = apply(data);
+			if (m_next) return m_next->process(result);
+			return result;
+		}
+
+		Image process(const Image& image) {
+			Image result = apply(image);
+			if (m_next) return m_next->process(result);
+			return result;
+		}
+
+		// Runs this stage only.
+		virtual std::string apply(std::string data) { return data; }
+
+		// Geometric filters get their pixel implementation from to_affine, resampled by the best SIMD kernel.
+		virtual Image apply(const Image& image) {
+			int width = image.width, height = image.height;
+			AffineTransform transform;
+			if (!to_affine(width, height, transform)) return image;
+
+			Image result(width, height);
+			warp_bilinear(image, result, transform);
+			return result;
 		}
+
+		// Geometric filters describe themselves as an affine transform so a chain can be folded into one pass.
+		// The width and height arguments hold the image size before the filter and are updated to the size after it.
+		virtual bool to_affine(int&, int&, AffineTransform&) const { return false; }
 	};
 
 	class RotateFilter : public Filter {
 	private:
 		float m_rot_angle = 0;
 	public:
+		using Filter::apply;
+
 		RotateFilter(float angle) : m_rot_angle(angle) { }
-		std::string process(std::string data) override {
+		void write_prefix(std::string& out) const {
+			char buf[32];
+			out.append("rotated(");
+			out.append(buf, std::snprintf(buf, sizeof(buf), "%f", m_rot_angle));
+			out.append("){");
+		}
+		bool to_affine(int& width, int& height, AffineTransform& transform) const override {
+			float partial_turn = std::fmod(m_rot_angle, 360.0f);
+			if (partial_turn == 0.0f) {
+				transform = AffineTransform();
+				return true;
+			}
+			const float radians = m_rot_angle * 3.14159265358979f / 180.0f;
+			const float cos_a = std::cos(radians), sin_a = std::sin(radians);
+			transform = { cos_a, -sin_a, sin_a, cos_a };
 
-			std::string result = "rotated(" + std::to_string(m_rot_angle) + "){" + data + "}";
-			if (m_next) return m_next->process(result);
+			int rotated_width = (int)std::lround(std::fabs(width * cos_a) + std::fabs(height * sin_a));
+			height = (int)std::lround(std::fabs(width * sin_a) + std::fabs(height * cos_a));
+			width = rotated_width;
+			return true;
+		}
+		std::string apply(std::string data) override {
+
+			std::string result;
+			write_prefix(result);
+			result += data + "}";
 			return result;
 		}
 	};
@@ -31,11 +100,26 @@ namespace cor_pattern {
 	private:
 		float m_scale_factor = 0;
 	public:
+		using Filter::apply;
+
 		ScaleFilter(float scale) : m_scale_factor(scale) { }
-		std::string process(std::string data) override {
+		void write_prefix(std::string& out) const {
+			char buf[32];
+			out.append("scale(");
+			out.append(buf, std::snprintf(buf, sizeof(buf), "%f", m_scale_factor));
+			out.append("x){");
+		}
+		bool to_affine(int& width, int& height, AffineTransform& transform) const override {
+			transform = { m_scale_factor, 0.0f, 0.0f, m_scale_factor };
+			width = (int)std::lround(width * m_scale_factor);
+			height = (int)std::lround(height * m_scale_factor);
+			return true;
+		}
+		std::string apply(std::string data) override {
 
-			std::string result = "scale(" + std::to_string(m_scale_factor) + "x){" + data + "}";
-			if (m_next) return m_next->process(result);
+			std::string result;
+			write_prefix(result);
+			result += data + "}";
 			return result;
 		}
 	};
@@ -44,12 +128,325 @@ namespace cor_pattern {
 	private:
 		int m_width = 0, m_height = 0;
 	public:
+		using Filter::apply;
+
 		ResizeFilter(int width, int heigth) : m_width(width), m_height(heigth) { }
-		std::string process(std::string data) override {
+		void write_prefix(std::string& out) const {
+			char buf[48];
+			out.append("resize(");
+			out.append(buf, std::snprintf(buf, sizeof(buf), "%d/%d", m_width, m_height));
+			out.append("x){");
+		}
+		bool to_affine(int& width, int& height, AffineTransform& transform) const override {
+			if (width <= 0 || height <= 0) return false;
+			transform = { (float)m_width / width, 0.0f, 0.0f, (float)m_height / height };
+			width = m_width;
+			height = m_height;
+			return true;
+		}
+		std::string apply(std::string data) override {
 
-			std::string result = "resize(" + std::to_string(m_width) + "/" + std::to_string(m_height) + "x){" + data + "}";
-			if (m_next) return m_next->process(result);
-			else return result;
+			std::string result;
+			write_prefix(result);
+			result += data + "}";
+			return result;
+		}
+	};
+
+
+	// Compile-time chain for pipelines known at build time. Stages are stored by value and called directly,
+	// so the whole chain inlines into one call that writes into a single caller-owned buffer.
+	// The result is identical to linking the same filters with set_next in the same order.
+	template<typename... Filters>
+	class StaticChain {
+	private:
+		std::tuple<Filters...> m_filters;
+
+		template<std::size_t... I>
+		void write_prefixes(std::string& out, std::index_sequence<I...>) const {
+			// The last stage wraps everything before it, so its prefix goes first.
+			(std::get<sizeof...(Filters) - 1 - I>(m_filters).write_prefix(out), ...);
+		}
+	public:
+		StaticChain(Filters... filters) : m_filters(std::move(filters)...) { }
+
+		// Reuses out's capacity, so repeated calls don't allocate once the buffer has grown.
+		void process(const std::string& data, std::string& out) const {
+			out.clear();
+			write_prefixes(out, std::index_sequence_for<Filters...>{});
+			out.append(data);
+			out.append(sizeof...(Filters), '}');
+		}
+
+		std::string process(const std::string& data) const {
+			std::string out;
+			process(data, out);
+			return out;
+		}
+	};
+
+	// Single-pass execution plan for a built Filter chain. Runs of adjacent affine filters are merged into one
+	// matrix, so N geometric filters cost one resampling pass. Runs that reduce to the identity
+	// (scale 1.0, rotate 0/360, resize to the current size) are dropped unless rounding changed the image size.
+	class FilterPlan {
+	private:
+		struct Step {
+			std::shared_ptr<Filter> filter; // empty for a merged affine pass
+			AffineTransform transform;
+			int width = 0, height = 0;
+		};
+		std::vector<Step> m_steps;
+		std::size_t m_source_filters = 0;
+
+		// start_width and start_height are the image size before the pending run, width and height after it.
+		void flush(AffineTransform& pending, bool& has_pending, int start_width, int start_height, int width, int height) {
+			bool resized = width != start_width || height != start_height;
+			if (has_pending && (resized || !pending.is_identity())) m_steps.push_back({ nullptr, pending, width, height });
+			pending = AffineTransform();
+			has_pending = false;
+		}
+	public:
+		// Throws std::invalid_argument when set_next has linked the chain back onto itself.
+		static FilterPlan compile(std::shared_ptr<Filter> root, int width, int height) {
+			FilterPlan plan;
+			std::unordered_set<const Filter*> visited;
+			AffineTransform pending;
+			bool has_pending = false;
+			int pending_width = width, pending_height = height;
+
+			for (std::shared_ptr<Filter> filter = root; filter; filter = filter->get_next()) {
+				if (!visited.insert(filter.get()).second) throw std::invalid_argument("Filter chain contains a cycle");
+				plan.m_source_filters++;
+
+				int next_width = width, next_height = height;
+				AffineTransform transform;
+				if (filter->to_affine(next_width, next_height, transform)) {
+					if (!has_pending) {
+						pending_width = width;
+						pending_height = height;
+					}
+					pending = pending.then(transform);
+					has_pending = true;
+				}
+				else {
+					plan.flush(pending, has_pending, pending_width, pending_height, width, height);
+					plan.m_steps.push_back({ filter, AffineTransform(), width, height });
+				}
+				width = next_width;
+				height = next_height;
+			}
+			plan.flush(pending, has_pending, pending_width, pending_height, width, height);
+			return plan;
+		}
+
+		std::size_t source_filters() const { return m_source_filters; }
+		std::size_t passes() const { return m_steps.size(); }
+
+		Image process(Image image) const {
+			for (const Step& step : m_steps) {
+				if (step.filter) {
+					image = step.filter->apply(image);
+					continue;
+				}
+				Image result(step.width, step.height);
+				warp_bilinear(image, result, step.transform);
+				image = std::move(result);
+			}
+			return image;
+		}
+
+		std::string process(std::string data) const {
+			for (const Step& step : m_steps) {
+				if (step.filter) {
+					data = step.filter->apply(data);
+					continue;
+				}
+				char buf[128];
+				int len = std::snprintf(buf, sizeof(buf), "affine(%.3f,%.3f,%.3f,%.3f -> %d/%d)",
+					step.transform.a, step.transform.b, step.transform.c, step.transform.d, step.width, step.height);
+				data = std::string(buf, len) + "{" + data + "}";
+			}
+			return data;
+		}
+	};
+
+	// Fixed set of worker threads that stay alive across run() calls. Each run() spreads its task indices over
+	// per-worker queues; a worker pops from the back of its own queue and steals from the front of the others.
+	class WorkStealingPool {
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<std::size_t> tasks;
+		};
+		unsigned m_workers;
+		std::vector<Queue> m_queues;
+		std::vector<std::thread> m_threads;
+
+		std::mutex m_run_mutex; // one run() at a time
+		std::mutex m_mutex;
+		std::condition_variable m_start, m_done;
+		const std::function<void(unsigned, std::size_t)>* m_task = nullptr;
+		std::uint64_t m_generation = 0;
+		unsigned m_busy = 0;
+		bool m_stop = false;
+
+		bool next_task(unsigned worker, std::size_t& index) {
+			for (unsigned k = 0; k < m_workers; k++) {
+				Queue& queue = m_queues[(worker + k) % m_workers];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				if (queue.tasks.empty()) continue;
+				if (k == 0) {
+					index = queue.tasks.back();
+					queue.tasks.pop_back();
+				}
+				else {
+					index = queue.tasks.front();
+					queue.tasks.pop_front();
+				}
+				return true;
+			}
+			return false;
+		}
+
+		void drain(unsigned worker) {
+			std::size_t index;
+			while (next_task(worker, index)) (*m_task)(worker, index);
+		}
+
+		void worker_loop(unsigned worker) {
+			std::uint64_t seen = 0;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_start.wait(lock, [&]() { return m_stop || m_generation != seen; });
+					if (m_stop) return;
+					seen = m_generation;
+				}
+				drain(worker);
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_busy == 0) m_done.notify_one();
+			}
+		}
+	public:
+		explicit WorkStealingPool(unsigned workers = std::thread::hardware_concurrency())
+			: m_workers(std::max(workers, 1u)), m_queues(m_workers) {
+			for (unsigned worker = 1; worker < m_workers; worker++) m_threads.emplace_back(&WorkStealingPool::worker_loop, this, worker);
+		}
+		~WorkStealingPool() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_start.notify_all();
+			for (auto& thread : m_threads) thread.join();
+		}
+		WorkStealingPool(const WorkStealingPool&) = delete;
+		WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+		unsigned workers() const { return m_workers; }
+
+		// Runs task(worker, index) for every index in [0, count) and returns once all of them are done.
+		// The calling thread works as worker 0.
+		void run(std::size_t count, const std::function<void(unsigned, std::size_t)>& task) {
+			std::lock_guard<std::mutex> run_lock(m_run_mutex);
+			for (std::size_t i = 0; i < count; i++) {
+				Queue& queue = m_queues[i * m_workers / count];
+				std::lock_guard<std::mutex> lock(queue.mutex);
+				queue.tasks.push_back(i);
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_task = &task;
+				m_busy = m_workers - 1;
+				m_generation++;
+			}
+			m_start.notify_all();
+			drain(0);
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [&]() { return m_busy == 0; });
+			m_task = nullptr;
+		}
+	};
+
+	// Runs a chain of geometric filters tile by tile. For every output tile the chain is walked backwards to find
+	// the window each stage has to produce, resampling halo included, and then the whole chain runs on those
+	// small windows while they are still in L2. The result is identical to running each filter on the whole image.
+	class TiledExecutor {
+	private:
+		struct Stage {
+			AffineTransform transform;
+			int width = 0, height = 0; // stage output size
+		};
+		std::vector<Stage> m_stages;
+		int m_tile_size;
+		int m_input_width, m_input_height;
+		int m_width, m_height;
+	public:
+		// Throws std::invalid_argument for cyclic chains and for filters that have no affine description.
+		TiledExecutor(std::shared_ptr<Filter> root, int width, int height, int tile_size = 128)
+			: m_tile_size(tile_size), m_input_width(width), m_input_height(height), m_width(width), m_height(height) {
+			std::unordered_set<const Filter*> visited;
+			for (std::shared_ptr<Filter> filter = root; filter; filter = filter->get_next()) {
+				if (!visited.insert(filter.get()).second) throw std::invalid_argument("Filter chain contains a cycle");
+				Stage stage;
+				stage.width = m_width;
+				stage.height = m_height;
+				if (!filter->to_affine(stage.width, stage.height, stage.transform)) throw std::invalid_argument("Filter can't be tiled");
+				m_width = stage.width;
+				m_height = stage.height;
+				m_stages.push_back(stage);
+			}
+		}
+
+		int width() const { return m_width; }
+		int height() const { return m_height; }
+
+		// The stages are planned for one input size, other sizes throw std::invalid_argument.
+		Image process(const Image& image, WorkStealingPool& pool) const {
+			if (image.width != m_input_width || image.height != m_input_height)
+				throw std::invalid_argument("Image size differs from the size the tiled chain was planned for");
+			if (m_stages.empty()) return image;
+			Image result(m_width, m_height);
+
+			const int tiles_x = (m_width + m_tile_size - 1) / m_tile_size;
+			const int tiles_y = (m_height + m_tile_size - 1) / m_tile_size;
+			const std::size_t stage_count = m_stages.size();
+
+			// Per-worker scratch, reused across tiles so the hot loop never allocates after warm-up.
+			std::vector<std::vector<Image>> buffers(pool.workers(), std::vector<Image>(stage_count));
+			std::vector<std::vector<ImageWindow>> windows(pool.workers(), std::vector<ImageWindow>(stage_count));
+
+			pool.run((std::size_t)tiles_x * tiles_y, [&](unsigned worker, std::size_t index) {
+				std::vector<Image>& stage_buffers = buffers[worker];
+				std::vector<ImageWindow>& stage_windows = windows[worker];
+
+				ImageWindow& tile = stage_windows[stage_count - 1];
+				tile.x = (int)(index % tiles_x) * m_tile_size;
+				tile.y = (int)(index / tiles_x) * m_tile_size;
+				tile.width = std::min(m_tile_size, m_width - tile.x);
+				tile.height = std::min(m_tile_size, m_height - tile.y);
+				tile.full_width = m_width;
+				tile.full_height = m_height;
+				for (std::size_t k = stage_count - 1; k > 0; k--)
+					stage_windows[k - 1] = source_window(m_stages[k - 1].width, m_stages[k - 1].height, stage_windows[k], m_stages[k].transform);
+
+				// The first stage samples the source image in place, no copy of its window is needed.
+				const Image* input = &image;
+				ImageWindow input_window = ImageWindow::whole(image);
+				for (std::size_t k = 0; k < stage_count; k++) {
+					stage_buffers[k].reset(stage_windows[k].width, stage_windows[k].height);
+					warp_bilinear(*input, input_window, stage_buffers[k], stage_windows[k], m_stages[k].transform);
+					input = &stage_buffers[k];
+					input_window = stage_windows[k];
+				}
+
+				const std::size_t row_bytes = (std::size_t)tile.width * 4;
+				for (int y = 0; y < tile.height; y++)
+					std::memcpy(result.pixels.data() + ((std::size_t)(tile.y + y) * m_width + tile.x) * 4,
+						input->pixels.data() + y * row_bytes, row_bytes);
+			});
+			return result;
 		}
 	};
 }
@@ -84,5 +481,162 @@ int ChainOfResponsibilityPattern::run() {
 		std::cout << "\n" << "Scale resize and rotate pipeline: " << root_filter->process("Dog image") << std::endl;
 	}
 
+	//Same pipeline folded into a single pass
+	{
+		std::shared_ptr<Filter> root_filter = std::make_shared<ScaleFilter>(2.0f);
+		root_filter->set_next(std::make_shared<ResizeFilter>(1024, 768))
+			->set_next(std::make_shared<ScaleFilter>(1.0f))
+			->set_next(std::make_shared<RotateFilter>(90.0f))
+			->set_next(std::make_shared<RotateFilter>(360.0f));
+
+		FilterPlan plan = FilterPlan::compile(root_filter, 640, 480);
+		std::cout << "\n" << "Compiled pipeline(" << plan.source_filters() << " filters -> " << plan.passes() << " pass): " << plan.process("Dog image") << std::endl;
+		Image frame = plan.process(Image(640, 480));
+		std::cout << "Compiled pipeline on a 640/480 RGBA frame: " << frame.width << "/" << frame.height << std::endl;
+
+		// Halving and doubling an odd width folds to the identity matrix but still rounds the size up by one
+		std::shared_ptr<Filter> rounding_filter = std::make_shared<ScaleFilter>(0.5f);
+		rounding_filter->set_next(std::make_shared<ScaleFilter>(2.0f));
+		Image rounded = FilterPlan::compile(rounding_filter, 641, 480).process(Image(641, 480));
+		Image chained = rounding_filter->process(Image(641, 480));
+		std::cout << "Scale 0.5 then 2 on 641/480: plan " << rounded.width << "/" << rounded.height
+			<< ", chain " << chained.width << "/" << chained.height << std::endl;
+		if (rounded.width != chained.width || rounded.height != chained.height) return 1;
+
+		// Linking the chain back onto itself is caught instead of looping forever
+		std::shared_ptr<Filter> rotate_filter = std::make_shared<RotateFilter>(45.0f);
+		rotate_filter->set_next(root_filter);
+		root_filter->set_next(rotate_filter);
+		try {
+			FilterPlan::compile(root_filter, 640, 480);
+		}
+		catch (const std::invalid_argument& e) {
+			std::cout << "Cyclic pipeline rejected: " << e.what() << std::endl;
+		}
+		root_filter->set_next(nullptr);
+	}
+
+	//Real RGBA8 pixels through the same filters: SIMD kernels checked against the scalar reference
+	{
+		Image noise(333, 217);
+		unsigned int seed = 12345;
+		for (auto& channel : noise.pixels) {
+			seed = seed * 1664525u + 1013904223u;
+			channel = (std::uint8_t)(seed >> 24);
+		}
+
+		struct Kernel { const char* name; std::shared_ptr<Filter> filter; };
+		auto make_kernels = [](int width, int height) {
+			return std::vector<Kernel>{
+				{ "resize", std::make_shared<ResizeFilter>(width * 3 / 4, height * 3 / 4) },
+				{ "scale", std::make_shared<ScaleFilter>(1.25f) },
+				{ "rotate", std::make_shared<RotateFilter>(30.0f) }
+			};
+		};
+
+		std::cout << "\n" << "Pixel kernels(best: " << kernel_isa_name(best_kernel_isa()) << ")" << std::endl;
+		for (auto& kernel : make_kernels(noise.width, noise.height)) {
+			int width = noise.width, height = noise.height;
+			AffineTransform transform;
+			kernel.filter->to_affine(width, height, transform);
+
+			Image reference(width, height);
+			warp_bilinear(noise, reference, transform, KernelIsa::Scalar);
+			for (KernelIsa isa : { KernelIsa::SSE41, KernelIsa::AVX2 }) {
+				if (!kernel_isa_supported(isa)) continue;
+				Image result(width, height);
+				warp_bilinear(noise, result, transform, isa);
+
+				int max_diff = 0;
+				for (std::size_t i = 0; i < result.pixels.size(); i++)
+					max_diff = std::max(max_diff, std::abs(result.pixels[i] - reference.pixels[i]));
+				std::cout << "  " << kernel.name << " " << kernel_isa_name(isa) << " vs scalar: max diff " << max_diff << std::endl;
+				if (max_diff > 1) return 1;
+			}
+		}
+
+		struct Resolution { const char* name; int width, height; };
+		for (Resolution resolution : { Resolution{ "720p", 1280, 720 }, Resolution{ "1080p", 1920, 1080 }, Resolution{ "4K", 3840, 2160 } }) {
+			Image source(resolution.width, resolution.height);
+			for (std::size_t i = 0; i < source.pixels.size(); i++) source.pixels[i] = (std::uint8_t)(i * 31);
+
+			for (auto& kernel : make_kernels(source.width, source.height)) {
+				int width = source.width, height = source.height;
+				AffineTransform transform;
+				kernel.filter->to_affine(width, height, transform);
+
+				std::cout << "  " << resolution.name << " " << kernel.name << ":";
+				for (KernelIsa isa : { KernelIsa::Scalar, KernelIsa::SSE41, KernelIsa::AVX2 }) {
+					if (!kernel_isa_supported(isa)) continue;
+					Image result(width, height);
+					double ms = benchmark::elapsed_ms([&]() { warp_bilinear(source, result, transform, isa); });
+					std::cout << " " << kernel_isa_name(isa) << " " << (double)width * height / (ms * 1000.0) << " MP/s";
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+
+	//Tiled, multi-threaded execution of the same chain against whole-image sequential passes on 4K input
+	{
+		std::shared_ptr<Filter> root_filter = std::make_shared<ScaleFilter>(1.25f);
+		root_filter->set_next(std::make_shared<RotateFilter>(15.0f))->set_next(std::make_shared<ResizeFilter>(3840, 2160));
+
+		Image source(3840, 2160);
+		for (std::size_t i = 0; i < source.pixels.size(); i++) source.pixels[i] = (std::uint8_t)(i * 31 + i / 4096);
+
+		Image sequential;
+		double sequential_ms = benchmark::elapsed_ms([&]() { sequential = root_filter->process(source); });
+
+		TiledExecutor executor(root_filter, source.width, source.height);
+		WorkStealingPool single_worker(1), pool;
+		Image tiled_single, tiled;
+		double tiled_single_ms = benchmark::elapsed_ms([&]() { tiled_single = executor.process(source, single_worker); });
+		double tiled_ms = benchmark::elapsed_ms([&]() { tiled = executor.process(source, pool); });
+
+		// The pool keeps its threads, a second run reuses them
+		Image tiled_again = executor.process(source, pool);
+		if (tiled.pixels != sequential.pixels || tiled_single.pixels != sequential.pixels || tiled_again.pixels != sequential.pixels) {
+			std::cout << "\n" << "Tiled execution differs from sequential execution" << std::endl;
+			return 1;
+		}
+		std::cout << "\n" << "Tiled 4K pipeline(identical output): sequential " << sequential_ms << " ms, tiled 1 thread " << tiled_single_ms
+			<< " ms, tiled " << pool.workers() << " threads " << tiled_ms << " ms, speedup x" << sequential_ms / tiled_ms << std::endl;
+
+		try {
+			executor.process(Image(1920, 1080), pool);
+			return 1;
+		}
+		catch (const std::invalid_argument& error) {
+			std::cout << "Wrong input size: " << error.what() << std::endl;
+		}
+	}
+
+	//Same pipeline fixed at compile time
+	{
+		StaticChain<ScaleFilter, ResizeFilter, RotateFilter> chain(ScaleFilter(2.0f), ResizeFilter(1024, 768), RotateFilter(90.0f));
+		std::cout << "\n" << "Static scale resize and rotate pipeline: " << chain.process("Dog image") << std::endl;
+	}
+
+	//Static vs dynamic chain cost per item
+	{
+		const std::size_t items = 200000;
+
+		std::shared_ptr<Filter> root_filter = std::make_shared<ScaleFilter>(2.0f);
+		root_filter->set_next(std::make_shared<ResizeFilter>(1024, 768))->set_next(std::make_shared<RotateFilter>(90.0f));
+		double dynamic_ns = benchmark::ns_per_op(items, [&](std::size_t) {
+			benchmark::keep(root_filter->process("Dog image").size());
+		});
+
+		StaticChain<ScaleFilter, ResizeFilter, RotateFilter> chain(ScaleFilter(2.0f), ResizeFilter(1024, 768), RotateFilter(90.0f));
+		std::string out;
+		double static_ns = benchmark::ns_per_op(items, [&](std::size_t) {
+			chain.process("Dog image", out);
+			benchmark::keep(out.size());
+		});
+
+		std::cout << "\n" << "Benchmark(" << items << " items): dynamic chain " << dynamic_ns << " ns/item, static chain " << static_ns << " ns/item" << std::endl;
+	}
+
 	return 0;
 }
\ No newline at end of file
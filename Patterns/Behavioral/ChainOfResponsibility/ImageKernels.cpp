@@ -0,0 +1,383 @@
+#include "ImageKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC exposes every intrinsic unconditionally, GCC and Clang need the ISA enabled per function.
+// The shared sampling code is force-inlined so the SIMD loops never call out into non-VEX code.
+#if defined(__GNUC__)
+#define COR_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define COR_TARGET_AVX2 __attribute__((target("avx2")))
+#define COR_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define COR_TARGET_SSE41
+#define COR_TARGET_AVX2
+#define COR_FORCE_INLINE __forceinline
+#endif
+
+
+namespace cor_pattern {
+
+	namespace {
+
+		const std::uint8_t k_transparent[4] = { 0, 0, 0, 0 };
+
+		// The four source texels and weights that contribute to one destination pixel.
+		struct Sample {
+			const std::uint8_t* p00;
+			const std::uint8_t* p01;
+			const std::uint8_t* p10;
+			const std::uint8_t* p11;
+			float wx, wy;
+		};
+
+		// Inverse of transform, or false when it is singular.
+		bool invert(const AffineTransform& transform, AffineTransform& inverse) {
+			float det = transform.a * transform.d - transform.b * transform.c;
+			if (det == 0.0f) return false;
+			inverse = { transform.d / det, -transform.b / det, -transform.c / det, transform.a / det };
+			return true;
+		}
+
+		// Maps destination pixels back into the source, the reference for the coordinate math every kernel
+		// repeats. All math happens in full-image coordinates, so a window produces exactly the pixels of
+		// the whole image.
+		class Sampler {
+		private:
+			// Copies, not references: the kernels store through uint8_t pointers, which may alias anything.
+			const std::uint8_t* m_src;
+			ImageWindow m_src_window;
+			ImageWindow m_dst_window;
+			AffineTransform m_inverse;
+			float m_row_x = 0, m_row_y = 0;
+			bool m_valid = false;
+		public:
+			Sampler(const Image& src, const ImageWindow& src_window, const ImageWindow& dst_window, const AffineTransform& transform)
+				: m_src(src.pixels.data()), m_src_window(src_window), m_dst_window(dst_window) {
+				m_valid = src_window.width > 0 && src_window.height > 0 && invert(transform, m_inverse);
+			}
+
+			void set_row(int y) {
+				float px = 0.5f - m_dst_window.full_width * 0.5f;
+				float py = (m_dst_window.y + y) + 0.5f - m_dst_window.full_height * 0.5f;
+				m_row_x = m_inverse.a * px + m_inverse.b * py + m_src_window.full_width * 0.5f - 0.5f;
+				m_row_y = m_inverse.c * px + m_inverse.d * py + m_src_window.full_height * 0.5f - 0.5f;
+			}
+
+			COR_FORCE_INLINE Sample at(int x) const {
+				const int full_x = m_dst_window.x + x;
+				float fx = m_row_x + m_inverse.a * full_x;
+				float fy = m_row_y + m_inverse.c * full_x;
+				if (!m_valid || fx < -0.5f || fy < -0.5f || fx > m_src_window.full_width - 0.5f || fy > m_src_window.full_height - 0.5f)
+					return { k_transparent, k_transparent, k_transparent, k_transparent, 0.0f, 0.0f };
+
+				int x0 = (int)std::floor(fx), y0 = (int)std::floor(fy);
+				Sample sample;
+				sample.wx = fx - x0;
+				sample.wy = fy - y0;
+
+				int x0c = local_index(x0, m_src_window.x, m_src_window.width, m_src_window.full_width);
+				int x1c = local_index(x0 + 1, m_src_window.x, m_src_window.width, m_src_window.full_width);
+				int y0c = local_index(y0, m_src_window.y, m_src_window.height, m_src_window.full_height);
+				int y1c = local_index(y0 + 1, m_src_window.y, m_src_window.height, m_src_window.full_height);
+				const std::uint8_t* row0 = m_src + (std::size_t)y0c * m_src_window.width * 4;
+				const std::uint8_t* row1 = m_src + (std::size_t)y1c * m_src_window.width * 4;
+				sample.p00 = row0 + x0c * 4;
+				sample.p01 = row0 + x1c * 4;
+				sample.p10 = row1 + x0c * 4;
+				sample.p11 = row1 + x1c * 4;
+				return sample;
+			}
+
+			// Row setup and windows, for the kernels that generate coordinates for several pixels at once.
+			bool valid() const { return m_valid; }
+			float row_x() const { return m_row_x; }
+			float row_y() const { return m_row_y; }
+			const AffineTransform& inverse() const { return m_inverse; }
+			const ImageWindow& src_window() const { return m_src_window; }
+			const ImageWindow& dst_window() const { return m_dst_window; }
+			const std::uint8_t* src() const { return m_src; }
+
+		private:
+			// Clamps to the full image edge, then moves into the window.
+			static COR_FORCE_INLINE int local_index(int full_index, int origin, int size, int full_size) {
+				return std::clamp(std::clamp(full_index, 0, full_size - 1) - origin, 0, size - 1);
+			}
+		};
+
+		COR_FORCE_INLINE void blend_scalar(const Sample& s, std::uint8_t* out) {
+			for (int c = 0; c < 4; c++) {
+				float top = s.p00[c] * (1.0f - s.wx) + s.p01[c] * s.wx;
+				float bottom = s.p10[c] * (1.0f - s.wx) + s.p11[c] * s.wx;
+				float value = top * (1.0f - s.wy) + bottom * s.wy;
+				out[c] = (std::uint8_t)(value + 0.5f);
+			}
+		}
+
+		void warp_scalar(const Image& src, const ImageWindow& src_window, Image& dst, const ImageWindow& dst_window, const AffineTransform& transform) {
+			Sampler sampler(src, src_window, dst_window, transform);
+			for (int y = 0; y < dst_window.height; y++) {
+				sampler.set_row(y);
+				std::uint8_t* out = dst.pixels.data() + (std::size_t)y * dst_window.width * 4;
+				for (int x = 0; x < dst_window.width; x++) blend_scalar(sampler.at(x), out + x * 4);
+			}
+		}
+
+#if defined(COR_X86)
+		COR_FORCE_INLINE std::int32_t load_texel(const std::uint8_t* p) {
+			std::int32_t texel;
+			std::memcpy(&texel, p, 4);
+			return texel;
+		}
+
+		// The SIMD kernels repeat Sampler::at and blend_scalar across lanes with the same operations in the same
+		// order, so they produce exactly the scalar pixels. Lanes outside the source come out transparent.
+
+		template<int Shift>
+		COR_TARGET_SSE41 COR_FORCE_INLINE __m128 channel_sse(__m128i texels) {
+			return _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, Shift), _mm_set1_epi32(0xFF)));
+		}
+
+		template<int Shift>
+		COR_TARGET_SSE41 COR_FORCE_INLINE __m128i blend_channel_sse(__m128i t00, __m128i t01, __m128i t10, __m128i t11,
+			__m128 wx, __m128 iwx, __m128 wy, __m128 iwy) {
+			__m128 top = _mm_add_ps(_mm_mul_ps(channel_sse<Shift>(t00), iwx), _mm_mul_ps(channel_sse<Shift>(t01), wx));
+			__m128 bottom = _mm_add_ps(_mm_mul_ps(channel_sse<Shift>(t10), iwx), _mm_mul_ps(channel_sse<Shift>(t11), wx));
+			__m128 value = _mm_add_ps(_mm_mul_ps(top, iwy), _mm_mul_ps(bottom, wy));
+			return _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(value, _mm_set1_ps(0.5f))), Shift);
+		}
+
+		// Sampler::local_index across lanes.
+		COR_TARGET_SSE41 COR_FORCE_INLINE __m128i local_index_sse(__m128i full_index, int origin, int size, int full_size) {
+			__m128i clamped = _mm_min_epi32(_mm_max_epi32(full_index, _mm_setzero_si128()), _mm_set1_epi32(full_size - 1));
+			return _mm_min_epi32(_mm_max_epi32(_mm_sub_epi32(clamped, _mm_set1_epi32(origin)), _mm_setzero_si128()), _mm_set1_epi32(size - 1));
+		}
+
+		COR_TARGET_SSE41 COR_FORCE_INLINE __m128i fetch_sse(const std::uint8_t* src, __m128i offsets) {
+			alignas(16) std::int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), offsets);
+			return _mm_setr_epi32(load_texel(src + lanes[0]), load_texel(src + lanes[1]), load_texel(src + lanes[2]), load_texel(src + lanes[3]));
+		}
+
+		// Four pixels per iteration: coordinates, clamping and addressing run across lanes, texels are loaded per lane.
+		COR_TARGET_SSE41 void warp_sse41(const Image& src, const ImageWindow& src_window, Image& dst, const ImageWindow& dst_window, const AffineTransform& transform) {
+			Sampler sampler(src, src_window, dst_window, transform);
+			if (!sampler.valid()) {
+				warp_scalar(src, src_window, dst, dst_window, transform);
+				return;
+			}
+			const ImageWindow sw = sampler.src_window();
+			const std::uint8_t* texels = sampler.src();
+			const __m128 a = _mm_set1_ps(sampler.inverse().a), c = _mm_set1_ps(sampler.inverse().c), one = _mm_set1_ps(1.0f);
+			const __m128 low = _mm_set1_ps(-0.5f), high_x = _mm_set1_ps(sw.full_width - 0.5f), high_y = _mm_set1_ps(sw.full_height - 0.5f);
+			const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3), stride = _mm_set1_epi32(sw.width * 4), one_i = _mm_set1_epi32(1);
+
+			for (int y = 0; y < dst_window.height; y++) {
+				sampler.set_row(y);
+				const __m128 row_x = _mm_set1_ps(sampler.row_x()), row_y = _mm_set1_ps(sampler.row_y());
+				std::uint8_t* out = dst.pixels.data() + (std::size_t)y * dst_window.width * 4;
+				int x = 0;
+				for (; x + 4 <= dst_window.width; x += 4) {
+					__m128 full_x = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(dst_window.x + x), lanes));
+					__m128 fx = _mm_add_ps(row_x, _mm_mul_ps(a, full_x));
+					__m128 fy = _mm_add_ps(row_y, _mm_mul_ps(c, full_x));
+					__m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(fx, low), _mm_cmplt_ps(fy, low)),
+						_mm_or_ps(_mm_cmpgt_ps(fx, high_x), _mm_cmpgt_ps(fy, high_y)));
+
+					__m128 floor_x = _mm_floor_ps(fx), floor_y = _mm_floor_ps(fy);
+					__m128 wx = _mm_sub_ps(fx, floor_x), wy = _mm_sub_ps(fy, floor_y);
+					__m128i x0 = _mm_cvttps_epi32(floor_x), y0 = _mm_cvttps_epi32(floor_y);
+					__m128i x0c = _mm_slli_epi32(local_index_sse(x0, sw.x, sw.width, sw.full_width), 2);
+					__m128i x1c = _mm_slli_epi32(local_index_sse(_mm_add_epi32(x0, one_i), sw.x, sw.width, sw.full_width), 2);
+					__m128i row0 = _mm_mullo_epi32(local_index_sse(y0, sw.y, sw.height, sw.full_height), stride);
+					__m128i row1 = _mm_mullo_epi32(local_index_sse(_mm_add_epi32(y0, one_i), sw.y, sw.height, sw.full_height), stride);
+
+					__m128i t00 = fetch_sse(texels, _mm_add_epi32(row0, x0c)), t01 = fetch_sse(texels, _mm_add_epi32(row0, x1c));
+					__m128i t10 = fetch_sse(texels, _mm_add_epi32(row1, x0c)), t11 = fetch_sse(texels, _mm_add_epi32(row1, x1c));
+					__m128 iwx = _mm_sub_ps(one, wx), iwy = _mm_sub_ps(one, wy);
+					__m128i pixels = _mm_or_si128(
+						_mm_or_si128(blend_channel_sse<0>(t00, t01, t10, t11, wx, iwx, wy, iwy), blend_channel_sse<8>(t00, t01, t10, t11, wx, iwx, wy, iwy)),
+						_mm_or_si128(blend_channel_sse<16>(t00, t01, t10, t11, wx, iwx, wy, iwy), blend_channel_sse<24>(t00, t01, t10, t11, wx, iwx, wy, iwy)));
+					pixels = _mm_andnot_si128(_mm_castps_si128(outside), pixels);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), pixels);
+				}
+				for (; x < dst_window.width; x++) blend_scalar(sampler.at(x), out + x * 4);
+			}
+		}
+
+		template<int Shift>
+		COR_TARGET_AVX2 COR_FORCE_INLINE __m256 channel_avx2(__m256i texels) {
+			return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texels, Shift), _mm256_set1_epi32(0xFF)));
+		}
+
+		template<int Shift>
+		COR_TARGET_AVX2 COR_FORCE_INLINE __m256i blend_channel_avx2(__m256i t00, __m256i t01, __m256i t10, __m256i t11,
+			__m256 wx, __m256 iwx, __m256 wy, __m256 iwy) {
+			__m256 top = _mm256_add_ps(_mm256_mul_ps(channel_avx2<Shift>(t00), iwx), _mm256_mul_ps(channel_avx2<Shift>(t01), wx));
+			__m256 bottom = _mm256_add_ps(_mm256_mul_ps(channel_avx2<Shift>(t10), iwx), _mm256_mul_ps(channel_avx2<Shift>(t11), wx));
+			__m256 value = _mm256_add_ps(_mm256_mul_ps(top, iwy), _mm256_mul_ps(bottom, wy));
+			return _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_add_ps(value, _mm256_set1_ps(0.5f))), Shift);
+		}
+
+		COR_TARGET_AVX2 COR_FORCE_INLINE __m256i local_index_avx2(__m256i full_index, int origin, int size, int full_size) {
+			__m256i clamped = _mm256_min_epi32(_mm256_max_epi32(full_index, _mm256_setzero_si256()), _mm256_set1_epi32(full_size - 1));
+			return _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(clamped, _mm256_set1_epi32(origin)), _mm256_setzero_si256()), _mm256_set1_epi32(size - 1));
+		}
+
+		// Eight pixels per iteration: coordinates, clamping and addressing run across lanes, texels are gathered.
+		COR_TARGET_AVX2 void warp_avx2(const Image& src, const ImageWindow& src_window, Image& dst, const ImageWindow& dst_window, const AffineTransform& transform) {
+			Sampler sampler(src, src_window, dst_window, transform);
+			if (!sampler.valid()) {
+				warp_scalar(src, src_window, dst, dst_window, transform);
+				return;
+			}
+			const ImageWindow sw = sampler.src_window();
+			const int* texels = reinterpret_cast<const int*>(sampler.src());
+			const __m256 a = _mm256_set1_ps(sampler.inverse().a), c = _mm256_set1_ps(sampler.inverse().c), one = _mm256_set1_ps(1.0f);
+			const __m256 low = _mm256_set1_ps(-0.5f), high_x = _mm256_set1_ps(sw.full_width - 0.5f), high_y = _mm256_set1_ps(sw.full_height - 0.5f);
+			const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), stride = _mm256_set1_epi32(sw.width * 4), one_i = _mm256_set1_epi32(1);
+
+			for (int y = 0; y < dst_window.height; y++) {
+				sampler.set_row(y);
+				const __m256 row_x = _mm256_set1_ps(sampler.row_x()), row_y = _mm256_set1_ps(sampler.row_y());
+				std::uint8_t* out = dst.pixels.data() + (std::size_t)y * dst_window.width * 4;
+				int x = 0;
+				for (; x + 8 <= dst_window.width; x += 8) {
+					__m256 full_x = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(dst_window.x + x), lanes));
+					__m256 fx = _mm256_add_ps(row_x, _mm256_mul_ps(a, full_x));
+					__m256 fy = _mm256_add_ps(row_y, _mm256_mul_ps(c, full_x));
+					__m256 outside = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(fx, low, _CMP_LT_OQ), _mm256_cmp_ps(fy, low, _CMP_LT_OQ)),
+						_mm256_or_ps(_mm256_cmp_ps(fx, high_x, _CMP_GT_OQ), _mm256_cmp_ps(fy, high_y, _CMP_GT_OQ)));
+
+					__m256 floor_x = _mm256_floor_ps(fx), floor_y = _mm256_floor_ps(fy);
+					__m256 wx = _mm256_sub_ps(fx, floor_x), wy = _mm256_sub_ps(fy, floor_y);
+					__m256i x0 = _mm256_cvttps_epi32(floor_x), y0 = _mm256_cvttps_epi32(floor_y);
+					__m256i x0c = _mm256_slli_epi32(local_index_avx2(x0, sw.x, sw.width, sw.full_width), 2);
+					__m256i x1c = _mm256_slli_epi32(local_index_avx2(_mm256_add_epi32(x0, one_i), sw.x, sw.width, sw.full_width), 2);
+					__m256i row0 = _mm256_mullo_epi32(local_index_avx2(y0, sw.y, sw.height, sw.full_height), stride);
+					__m256i row1 = _mm256_mullo_epi32(local_index_avx2(_mm256_add_epi32(y0, one_i), sw.y, sw.height, sw.full_height), stride);
+
+					__m256i t00 = _mm256_i32gather_epi32(texels, _mm256_add_epi32(row0, x0c), 1);
+					__m256i t01 = _mm256_i32gather_epi32(texels, _mm256_add_epi32(row0, x1c), 1);
+					__m256i t10 = _mm256_i32gather_epi32(texels, _mm256_add_epi32(row1, x0c), 1);
+					__m256i t11 = _mm256_i32gather_epi32(texels, _mm256_add_epi32(row1, x1c), 1);
+					__m256 iwx = _mm256_sub_ps(one, wx), iwy = _mm256_sub_ps(one, wy);
+					__m256i pixels = _mm256_or_si256(
+						_mm256_or_si256(blend_channel_avx2<0>(t00, t01, t10, t11, wx, iwx, wy, iwy), blend_channel_avx2<8>(t00, t01, t10, t11, wx, iwx, wy, iwy)),
+						_mm256_or_si256(blend_channel_avx2<16>(t00, t01, t10, t11, wx, iwx, wy, iwy), blend_channel_avx2<24>(t00, t01, t10, t11, wx, iwx, wy, iwy)));
+					pixels = _mm256_andnot_si256(_mm256_castps_si256(outside), pixels);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x * 4), pixels);
+				}
+				for (; x < dst_window.width; x++) blend_scalar(sampler.at(x), out + x * 4);
+			}
+		}
+
+		bool cpu_has_sse41() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			return (info[2] & (1 << 19)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.1");
+#endif
+		}
+
+		bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+			if (!os_saves_ymm) return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+#endif
+	}
+
+	bool kernel_isa_supported(KernelIsa isa) {
+		switch (isa) {
+#if defined(COR_X86)
+		case KernelIsa::AVX2: {
+			static const bool supported = cpu_has_avx2();
+			return supported;
+		}
+		case KernelIsa::SSE41: {
+			static const bool supported = cpu_has_sse41();
+			return supported;
+		}
+#endif
+		case KernelIsa::Scalar: return true;
+		default: return false;
+		}
+	}
+
+	KernelIsa best_kernel_isa() {
+		static const KernelIsa isa = kernel_isa_supported(KernelIsa::AVX2) ? KernelIsa::AVX2
+			: kernel_isa_supported(KernelIsa::SSE41) ? KernelIsa::SSE41 : KernelIsa::Scalar;
+		return isa;
+	}
+
+	const char* kernel_isa_name(KernelIsa isa) {
+		switch (isa) {
+		case KernelIsa::AVX2: return "AVX2";
+		case KernelIsa::SSE41: return "SSE4.1";
+		default: return "scalar";
+		}
+	}
+
+	void warp_bilinear(const Image& src, const ImageWindow& src_window, Image& dst, const ImageWindow& dst_window, const AffineTransform& transform, KernelIsa isa) {
+		if (!kernel_isa_supported(isa)) isa = KernelIsa::Scalar;
+		switch (isa) {
+#if defined(COR_X86)
+		case KernelIsa::AVX2: warp_avx2(src, src_window, dst, dst_window, transform); return;
+		case KernelIsa::SSE41: warp_sse41(src, src_window, dst, dst_window, transform); return;
+#endif
+		default: warp_scalar(src, src_window, dst, dst_window, transform); return;
+		}
+	}
+
+	void warp_bilinear(const Image& src, Image& dst, const AffineTransform& transform, KernelIsa isa) {
+		warp_bilinear(src, ImageWindow::whole(src), dst, ImageWindow::whole(dst), transform, isa);
+	}
+
+	ImageWindow source_window(int src_width, int src_height, const ImageWindow& dst_window, const AffineTransform& transform) {
+		ImageWindow window = { 0, 0, src_width, src_height, src_width, src_height };
+		AffineTransform inverse;
+		if (!invert(transform, inverse) || dst_window.width <= 0 || dst_window.height <= 0) return window;
+
+		float min_x = 1e30f, min_y = 1e30f, max_x = -1e30f, max_y = -1e30f;
+		for (int corner = 0; corner < 4; corner++) {
+			float px = dst_window.x + (corner & 1 ? dst_window.width - 0.5f : 0.5f) - dst_window.full_width * 0.5f;
+			float py = dst_window.y + (corner & 2 ? dst_window.height - 0.5f : 0.5f) - dst_window.full_height * 0.5f;
+			float fx = inverse.a * px + inverse.b * py + src_width * 0.5f - 0.5f;
+			float fy = inverse.c * px + inverse.d * py + src_height * 0.5f - 0.5f;
+			min_x = std::min(min_x, fx); max_x = std::max(max_x, fx);
+			min_y = std::min(min_y, fy); max_y = std::max(max_y, fy);
+		}
+
+		// Bilinear footprint plus one pixel of halo to absorb float rounding in the sampler.
+		int x0 = std::clamp((int)std::floor(min_x) - 1, 0, src_width), x1 = std::clamp((int)std::floor(max_x) + 3, 0, src_width);
+		int y0 = std::clamp((int)std::floor(min_y) - 1, 0, src_height), y1 = std::clamp((int)std::floor(max_y) + 3, 0, src_height);
+		window.x = x0;
+		window.y = y0;
+		window.width = std::max(x1 - x0, 1);
+		window.height = std::max(y1 - y0, 1);
+		if (window.x + window.width > src_width) window.x = src_width - window.width;
+		if (window.y + window.height > src_height) window.y = src_height - window.height;
+		return window;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace cor_pattern {
+
+	// Linear part of a 2D affine transform. Every geometric filter pivots around the image centre,
+	// so there is no translation to carry.
+	struct AffineTransform {
+		float a = 1.0f, b = 0.0f;
+		float c = 0.0f, d = 1.0f;
+
+		// Transform that applies this one first and then next.
+		AffineTransform then(const AffineTransform& next) const {
+			return { next.a * a + next.b * c, next.a * b + next.b * d,
+					 next.c * a + next.d * c, next.c * b + next.d * d };
+		}
+		bool is_identity() const { return a == 1.0f && b == 0.0f && c == 0.0f && d == 1.0f; }
+	};
+
+	// Tightly packed RGBA8 image.
+	struct Image {
+		int width = 0, height = 0;
+		std::vector<std::uint8_t> pixels;
+
+		Image() = default;
+		Image(int w, int h) : width(w), height(h), pixels((std::size_t)w * h * 4) {}
+
+		// Resizes in place, keeping the allocation when it is already large enough.
+		void reset(int w, int h) {
+			width = w;
+			height = h;
+			pixels.resize((std::size_t)w * h * 4);
+		}
+	};
+
+	// Where an Image buffer sits inside a larger full image. Kernels do their coordinate math in full-image
+	// space, so filling a window gives exactly the pixels a whole-image pass would produce there.
+	struct ImageWindow {
+		int x = 0, y = 0, width = 0, height = 0;
+		int full_width = 0, full_height = 0;
+
+		static ImageWindow whole(const Image& image) { return { 0, 0, image.width, image.height, image.width, image.height }; }
+	};
+
+	enum class KernelIsa { Scalar, SSE41, AVX2 };
+
+	// Widest instruction set the running CPU supports, detected once.
+	KernelIsa best_kernel_isa();
+	bool kernel_isa_supported(KernelIsa isa);
+	const char* kernel_isa_name(KernelIsa isa);
+
+	// Bilinear resampling of src into the already sized dst. transform maps centred source coordinates to
+	// centred destination coordinates; destination pixels that fall outside the source become transparent.
+	void warp_bilinear(const Image& src, Image& dst, const AffineTransform& transform, KernelIsa isa = best_kernel_isa());
+
+	// Same resampling for one window: src holds src_window of the source image, dst receives dst_window of the result.
+	void warp_bilinear(const Image& src, const ImageWindow& src_window, Image& dst, const ImageWindow& dst_window,
+		const AffineTransform& transform, KernelIsa isa = best_kernel_isa());
+
+	// Source pixels, halo included, that warp_bilinear reads to fill dst_window.
+	ImageWindow source_window(int src_width, int src_height, const ImageWindow& dst_window, const AffineTransform& transform);
+}
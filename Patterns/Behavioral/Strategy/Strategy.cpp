@@ -1,65 +1,295 @@
 #include "Strategy.h"
+#include "../../Benchmark.h"
 
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <typeindex>
 #include <vector>
 
 
 namespace strategy_pattern {
 
+	// Destination for unit actions, so simulation code doesn't talk to the console directly.
+	class ActionSink {
+	public:
+		virtual ~ActionSink() = default;
+		virtual void append(const char* text, std::size_t length) = 0;
+		virtual void flush() {}
+
+		ActionSink& operator<<(const char* text) {
+			append(text, std::strlen(text));
+			return *this;
+		}
+		ActionSink& operator<<(int value) {
+			char digits[16];
+			char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+			append(digits, end - digits);
+			return *this;
+		}
+	};
+
+	// Formats into a preallocated buffer and hands it to the stream in one write when it fills up
+	// or when the caller flushes at the end of a tick.
+	class BufferedSink : public ActionSink {
+	private:
+		std::ostream& m_out;
+		std::vector<char> m_buffer;
+		std::size_t m_size = 0;
+	public:
+		BufferedSink(std::ostream& out, std::size_t capacity = 64 * 1024) : m_out(out), m_buffer(capacity) {}
+		~BufferedSink() { flush(); }
+
+		void append(const char* text, std::size_t length) override {
+			if (m_size + length > m_buffer.size()) {
+				flush();
+				if (length > m_buffer.size()) {
+					m_out.write(text, length);
+					return;
+				}
+			}
+			std::memcpy(m_buffer.data() + m_size, text, length);
+			m_size += length;
+		}
+
+		void flush() override {
+			if (m_size == 0) return;
+			m_out.write(m_buffer.data(), m_size);
+			m_out.flush();
+			m_size = 0;
+		}
+	};
+
+	// Discards everything, for measuring pure simulation cost.
+	class NullSink : public ActionSink {
+	public:
+		void append(const char*, std::size_t) override {}
+	};
+
+	// Writes straight through to the stream, so output keeps its order relative to other writes to it.
+	class StreamSink : public ActionSink {
+	private:
+		std::ostream& m_out;
+	public:
+		StreamSink(std::ostream& out) : m_out(out) {}
+		void append(const char* text, std::size_t length) override { m_out.write(text, (std::streamsize)length); }
+		void flush() override { m_out.flush(); }
+	};
+
+	// Unbuffered console output, the default for a plain attack(). Batching output is opt-in: pass a
+	// BufferedSink and flush it at the end of the tick.
+	inline ActionSink& console_sink() {
+		static StreamSink sink(std::cout);
+		return sink;
+	}
+
+	// Strategies are stateless and immutable, so units share them instead of owning a copy each.
 	class AttackType {
 	public:
-		virtual void execute() = 0;
+		virtual void execute(ActionSink& sink) const = 0;
+		virtual int damage() const = 0;
+
+		// Resolves a whole batch of units that share this strategy: one virtual call, one tight loop.
+		virtual void execute_batch(int* damage_out, std::size_t count) const {
+			const int hit = damage();
+			for (std::size_t i = 0; i < count; i++) damage_out[i] = hit;
+		}
 	};
 
-	class SwordAttack : public AttackType {
+	class SwordAttack final : public AttackType {
 	public:
-		virtual void execute() {
-			std::cout << "Sword strike" << "\n";
+		static constexpr int k_damage = 10;
+		virtual void execute(ActionSink& sink) const {
+			sink << "Sword strike" << "\n";
 		};
+		virtual int damage() const { return k_damage; }
 	};
 
-	class BowAttack : public AttackType {
+	class BowAttack final : public AttackType {
 	public:
-		virtual void execute() {
-			std::cout << "Bow shot" << "\n";
+		static constexpr int k_damage = 6;
+		virtual void execute(ActionSink& sink) const {
+			sink << "Bow shot" << "\n";
 		};
+		virtual int damage() const { return k_damage; }
 	};
 
-	class PunchAttack : public AttackType {
+	class PunchAttack final : public AttackType {
 	public:
-		virtual void execute() {
-			std::cout << "Fist strike" << "\n";
+		static constexpr int k_damage = 2;
+		virtual void execute(ActionSink& sink) const {
+			sink << "Fist strike" << "\n";
 		};
+		virtual int damage() const { return k_damage; }
 	};
 
+	// The one shared instance of a strategy type.
+	template<typename T>
+	std::shared_ptr<const AttackType> shared_attack() {
+		static const std::shared_ptr<const AttackType> instance = std::make_shared<const T>();
+		return instance;
+	}
+
 	
+	// Strategy holder that worker threads read while a control thread swaps it. A read is one atomic load.
+	// A slot is the raw pointer readers load plus the shared_ptr that owns it. Swapped-out strategies move to
+	// one retire list shared by all slots and are released by collect_retired() between ticks, when no reader
+	// can still be using them, so a reader never touches a freed strategy.
+	class StrategySlot {
+	private:
+		std::atomic<const AttackType*> m_current;
+		std::shared_ptr<const AttackType> m_owner; // written under writer_mutex only
+
+		// Swaps are rare, so every slot shares one writer lock, which also guards the retire list.
+		static std::mutex& writer_mutex() {
+			static std::mutex mutex;
+			return mutex;
+		}
+		static std::vector<std::shared_ptr<const AttackType>>& retired() {
+			static std::vector<std::shared_ptr<const AttackType>> strategies;
+			return strategies;
+		}
+	public:
+		StrategySlot(std::shared_ptr<const AttackType> attack_type) : m_current(attack_type.get()), m_owner(std::move(attack_type)) {}
+
+		const AttackType& get() const { return *m_current.load(std::memory_order_acquire); }
+
+		void set(std::shared_ptr<const AttackType> attack_type) {
+			std::lock_guard<std::mutex> lock(writer_mutex());
+			if (attack_type == m_owner) return;
+			m_current.store(attack_type.get(), std::memory_order_release);
+			retired().push_back(std::move(m_owner));
+			m_owner = std::move(attack_type);
+		}
+
+		// Releases every swapped-out strategy. Only call while no thread is reading any slot, e.g. between ticks.
+		static void collect_retired() {
+			std::vector<std::shared_ptr<const AttackType>> released;
+			std::lock_guard<std::mutex> lock(writer_mutex());
+			released.swap(retired());
+		}
+
+		static std::size_t retired_count() {
+			std::lock_guard<std::mutex> lock(writer_mutex());
+			return retired().size();
+		}
+	};
+
 	class Unit {
 	protected:
-		std::shared_ptr<AttackType> m_attack_type;
+		StrategySlot m_attack_type;
 		int m_id;
 	public:
 		Unit() = delete;
-		Unit(int id, std::shared_ptr<AttackType> attack_type) : m_attack_type(attack_type), m_id(id){}
-		void set_attack_type(std::shared_ptr<AttackType> attack_type) { m_attack_type = attack_type; }
+		Unit(int id, std::shared_ptr<const AttackType> attack_type) : m_attack_type(attack_type), m_id(id){}
+
+		// Safe to call while other threads attack with this unit.
+		void set_attack_type(std::shared_ptr<const AttackType> attack_type) { m_attack_type.set(attack_type); }
 
-		void attack() {
-			std::cout << "Unit: " + std::to_string(m_id) + " executes attack: ";
-			m_attack_type->execute();
+		void attack(ActionSink& sink = console_sink()) {
+			sink << "Unit: " << m_id << " executes attack: ";
+			m_attack_type.get().execute(sink);
 		}
+
+		// Attack without the console output, for simulation.
+		int strike() { return m_attack_type.get().damage(); }
 	};
 
 	class Archer : public Unit {
 	public:
-		Archer(int id) : Unit(id, std::make_shared<BowAttack>()) {}
+		Archer(int id) : Unit(id, shared_attack<BowAttack>()) {}
 	};
 
 	class Knight : public Unit {
 	public:
-		Knight(int id) : Unit(id, std::make_shared<SwordAttack>()) {}
+		Knight(int id) : Unit(id, shared_attack<SwordAttack>()) {}
 	};
 
 	class Peasant : public Unit {
 	public:
-		Peasant(int id) : Unit(id, std::make_shared<PunchAttack>()) {}
+		Peasant(int id) : Unit(id, shared_attack<PunchAttack>()) {}
+	};
+
+
+	enum class AttackKind : std::uint8_t { Sword, Bow, Punch };
+
+	// Closed alternative to Unit for when the strategy set is fixed: the strategy is a one-byte tag
+	// dispatched with a switch, so a unit is 8 bytes in a contiguous array with no heap object at all.
+	struct CompactUnit {
+		int id;
+		AttackKind attack_kind;
+
+		int strike() const {
+			switch (attack_kind) {
+			case AttackKind::Sword: return SwordAttack::k_damage;
+			case AttackKind::Bow: return BowAttack::k_damage;
+			default: return PunchAttack::k_damage;
+			}
+		}
+	};
+
+	// Counts the bytes allocated through it, used to measure the heap cost of a unit representation.
+	template<typename T>
+	struct CountingAllocator {
+		using value_type = T;
+		std::size_t* m_bytes;
+
+		CountingAllocator(std::size_t* bytes) : m_bytes(bytes) {}
+		template<typename U> CountingAllocator(const CountingAllocator<U>& other) : m_bytes(other.m_bytes) {}
+
+		T* allocate(std::size_t n) {
+			*m_bytes += n * sizeof(T);
+			return std::allocator<T>().allocate(n);
+		}
+		void deallocate(T* p, std::size_t n) { std::allocator<T>().deallocate(p, n); }
+
+		template<typename U> bool operator==(const CountingAllocator<U>& other) const { return m_bytes == other.m_bytes; }
+		template<typename U> bool operator!=(const CountingAllocator<U>& other) const { return m_bytes != other.m_bytes; }
+	};
+
+	// A unit owns nothing on the heap besides its strategy, so allocating units and strategies through a
+	// CountingAllocator accounts for all of its memory.
+	static_assert(sizeof(StrategySlot) == sizeof(const AttackType*) + sizeof(std::shared_ptr<const AttackType>), "StrategySlot must stay one pointer plus one owner");
+
+	// Data-oriented army for large simulations. Units are stored in contiguous arrays grouped by the dynamic
+	// type of their strategy, so an attack tick is one virtual call and one tight loop per strategy instead of
+	// a pointer chase and a virtual call per unit.
+	class Army {
+	private:
+		struct Batch {
+			std::type_index type;
+			std::shared_ptr<const AttackType> attack_type;
+			std::vector<int> unit_ids;
+			std::vector<int> damage; // damage dealt by each unit during the last tick
+		};
+		std::vector<Batch> m_batches;
+	public:
+		void add_unit(int id, std::shared_ptr<const AttackType> attack_type) {
+			std::type_index type(typeid(*attack_type));
+			for (auto& batch : m_batches) {
+				if (batch.type != type) continue;
+				batch.unit_ids.push_back(id);
+				return;
+			}
+			m_batches.push_back({ type, attack_type, { id }, {} });
+		}
+
+		std::size_t batch_count() const { return m_batches.size(); }
+
+		// Every unit attacks once. Returns the total damage dealt.
+		long long tick() {
+			long long total = 0;
+			for (auto& batch : m_batches) {
+				batch.damage.resize(batch.unit_ids.size());
+				batch.attack_type->execute_batch(batch.damage.data(), batch.damage.size());
+				for (int hit : batch.damage) total += hit;
+			}
+			return total;
+		}
 	};
 }
 
@@ -82,13 +312,154 @@ int StrategyPattern::run() {
 		std::shared_ptr<Unit> peasant = std::make_shared<Peasant>(units.size());
 
 		// Let's give some Peasants Bows, let's say 20%
-		if ((rand() % 101) < 20) peasant->set_attack_type(std::make_shared<BowAttack>());
+		if ((rand() % 101) < 20) peasant->set_attack_type(shared_attack<BowAttack>());
 
 		units.push_back(peasant);
 	}
 
 	std::cout << "\n" << "Army Attack: " << "\n";
-	for (auto& unit : units) unit->attack();
+	BufferedSink sink(std::cout);
+	for (auto& unit : units) unit->attack(sink);
+	sink.flush();
+
+	// Large army: one attack tick over per-unit objects against the batched, strategy-grouped layout
+	{
+		const int army_size = 1000000;
+		std::vector<std::shared_ptr<Unit>> large_units;
+		Army army;
+		large_units.reserve(army_size);
+		for (int id = 0; id < army_size; id++) {
+			switch (id % 3) {
+			case 0: large_units.push_back(std::make_shared<Knight>(id)); army.add_unit(id, shared_attack<SwordAttack>()); break;
+			case 1: large_units.push_back(std::make_shared<Archer>(id)); army.add_unit(id, shared_attack<BowAttack>()); break;
+			default: large_units.push_back(std::make_shared<Peasant>(id)); army.add_unit(id, shared_attack<PunchAttack>()); break;
+			}
+		}
+
+		long long per_unit_damage = 0, batched_damage = 0;
+		double per_unit_ms = benchmark::elapsed_ms([&]() { for (auto& unit : large_units) per_unit_damage += unit->strike(); });
+		double batched_ms = benchmark::elapsed_ms([&]() { batched_damage = army.tick(); });
+
+		std::cout << "\n" << "Benchmark(" << army_size << " units, damage " << per_unit_damage << "/" << batched_damage << "): per-unit attack "
+			<< per_unit_ms << " ms, batched attack(" << army.batch_count() << " batches) " << batched_ms << " ms" << std::endl;
+		if (per_unit_damage != batched_damage) return 1;
+	}
+
+	// Attack output cost: formatting straight into a stream per fragment, through a buffered sink, and into a null sink.
+	// The stream only counts bytes, so terminal speed doesn't enter the measurement.
+	{
+		class CountingBuffer : public std::streambuf {
+		public:
+			std::size_t m_bytes = 0;
+		protected:
+			int_type overflow(int_type c) override { m_bytes++; return c; }
+			std::streamsize xsputn(const char*, std::streamsize count) override { m_bytes += (std::size_t)count; return count; }
+		};
+
+		const int army_size = 200000;
+		std::vector<std::shared_ptr<Unit>> army;
+		army.reserve(army_size);
+		for (int id = 0; id < army_size; id++) army.push_back(std::make_shared<Knight>(id));
+
+		CountingBuffer direct_buffer, buffered_buffer;
+		std::ostream direct_stream(&direct_buffer), buffered_stream(&buffered_buffer);
+		double direct_ms = benchmark::elapsed_ms([&]() {
+			for (int id = 0; id < army_size; id++) {
+				direct_stream << "Unit: " + std::to_string(id) + " executes attack: ";
+				direct_stream << "Sword strike" << "\n";
+			}
+		});
+
+		BufferedSink buffered_sink(buffered_stream);
+		double buffered_ms = benchmark::elapsed_ms([&]() {
+			for (auto& unit : army) unit->attack(buffered_sink);
+			buffered_sink.flush();
+		});
+
+		NullSink null_sink;
+		double null_ms = benchmark::elapsed_ms([&]() { for (auto& unit : army) unit->attack(null_sink); });
+
+		std::cout << "\n" << "Attack output(" << army_size << " units, " << buffered_buffer.m_bytes << " bytes): per-fragment stream " << direct_ms
+			<< " ms, buffered sink " << buffered_ms << " ms, null sink " << null_ms << " ms" << std::endl;
+		if (direct_buffer.m_bytes != buffered_buffer.m_bytes) return 1;
+	}
+
+	// Strategy hot-swap: readers attack concurrently while a control thread keeps swapping strategies,
+	// including fresh instances that must stay alive until the retire list is collected after the tick
+	{
+		Peasant peasant(0);
+		std::atomic<bool> bad_read(false);
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 4; t++) {
+			readers.emplace_back([&]() {
+				for (int i = 0; i < 200000; i++) {
+					int hit = peasant.strike();
+					if (hit != SwordAttack::k_damage && hit != BowAttack::k_damage && hit != PunchAttack::k_damage) bad_read = true;
+				}
+			});
+		}
+		for (int i = 0; i < 20000; i++) {
+			switch (i % 4) {
+			case 0: peasant.set_attack_type(shared_attack<SwordAttack>()); break;
+			case 1: peasant.set_attack_type(std::make_shared<BowAttack>()); break;
+			case 2: peasant.set_attack_type(shared_attack<PunchAttack>()); break;
+			default: peasant.set_attack_type(std::make_shared<SwordAttack>()); break;
+			}
+		}
+		for (auto& reader : readers) reader.join();
+
+		std::size_t retired_before = StrategySlot::retired_count();
+		StrategySlot::collect_retired();
+		std::cout << "\n" << "Strategy hot-swap stress(4 readers, 20000 swaps): " << (bad_read ? "FAILED" : "OK")
+			<< ", retired strategies " << retired_before << " -> " << StrategySlot::retired_count() << " after collect" << std::endl;
+		if (bad_read) return 1;
+
+		std::mutex mutex;
+		std::shared_ptr<const AttackType> locked_attack = shared_attack<SwordAttack>();
+		const std::size_t reads = 2000000;
+		double slot_ns = benchmark::ns_per_op(reads, [&](std::size_t) { benchmark::keep(peasant.strike()); });
+		double mutex_ns = benchmark::ns_per_op(reads, [&](std::size_t) {
+			std::lock_guard<std::mutex> lock(mutex);
+			benchmark::keep(locked_attack->damage());
+		});
+		std::cout << "Strategy read: atomic slot " << slot_ns << " ns, mutex " << mutex_ns << " ns" << std::endl;
+	}
+
+	// Memory per unit and attack throughput: strategy copy per unit, shared strategy, and closed enum dispatch.
+	// Units, strategies and the army vector all allocate through one CountingAllocator
+	{
+		const int army_size = 1000000;
+		struct Measurement { std::size_t bytes = 0; long long damage = 0; double ms = 0; };
+		Measurement copied, shared, compact;
+
+		{
+			CountingAllocator<Unit> allocator(&copied.bytes);
+			std::vector<std::shared_ptr<Unit>, CountingAllocator<std::shared_ptr<Unit>>> army(allocator);
+			army.reserve(army_size);
+			for (int id = 0; id < army_size; id++)
+				army.push_back(std::allocate_shared<Unit>(allocator, id, std::allocate_shared<SwordAttack>(CountingAllocator<SwordAttack>(allocator))));
+			copied.ms = benchmark::elapsed_ms([&]() { for (auto& unit : army) copied.damage += unit->strike(); });
+		}
+		{
+			CountingAllocator<Knight> allocator(&shared.bytes);
+			std::vector<std::shared_ptr<Unit>, CountingAllocator<std::shared_ptr<Unit>>> army(allocator);
+			army.reserve(army_size);
+			for (int id = 0; id < army_size; id++) army.push_back(std::allocate_shared<Knight>(allocator, id));
+			shared.ms = benchmark::elapsed_ms([&]() { for (auto& unit : army) shared.damage += unit->strike(); });
+		}
+		{
+			std::vector<CompactUnit, CountingAllocator<CompactUnit>> army(CountingAllocator<CompactUnit>(&compact.bytes));
+			army.reserve(army_size);
+			for (int id = 0; id < army_size; id++) army.push_back({ id, AttackKind::Sword });
+			compact.ms = benchmark::elapsed_ms([&]() { for (auto& unit : army) compact.damage += unit.strike(); });
+		}
+
+		std::cout << "\n" << "Unit representations(" << army_size << " units):" << "\n"
+			<< "  strategy per unit: " << copied.bytes / army_size << " bytes/unit, attack loop " << copied.ms << " ms" << "\n"
+			<< "  shared strategy: " << shared.bytes / army_size << " bytes/unit, attack loop " << shared.ms << " ms" << "\n"
+			<< "  enum strategy: " << compact.bytes / army_size << " bytes/unit, attack loop " << compact.ms << " ms" << std::endl;
+		if (copied.damage != shared.damage || shared.damage != compact.damage) return 1;
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Small timing helpers used by the pattern demos to compare a naive and an optimized variant.
+namespace benchmark {
+
+	// Runs func(i) for i in [0, iterations) and returns average nanoseconds per call.
+	template<typename Func>
+	double ns_per_op(std::size_t iterations, Func func) {
+		auto start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; i++) func(i);
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / (double)iterations;
+	}
+
+	// Runs func once and returns elapsed milliseconds.
+	template<typename Func>
+	double elapsed_ms(Func func) {
+		auto start = std::chrono::steady_clock::now();
+		func();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	inline volatile std::size_t g_sink = 0;
+
+	// Publishes a value so the optimizer can't drop the work that produced it.
+	inline void keep(std::size_t value) {
+		g_sink = value;
+	}
+}
@@ -1,7 +1,33 @@
 #include "AbstractFactory.h"
+#include "../../Benchmark.h"
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 namespace abstract_factory_pattern {
 
@@ -13,142 +39,469 @@ namespace abstract_factory_pattern {
 		int m_mana;
 	};
 
-	class OrcWarior : public Entity {
-	public:
-		OrcWarior(int id) {
-			this->m_health = 100;
-			this->m_mana = 0;
-			this->m_damage = 10;
-			this->m_id = id;
-		}
+	// Races compiled in. Races loaded at startup take the values after them.
+	enum class Race : std::uint8_t { Human, Elf, Orc };
+	enum class Role : std::uint8_t { Warior, Mage, Pet, Count };
+
+	constexpr std::size_t k_builtin_races = 3;
+
+	struct EntityStats {
+		int health;
+		int damage;
+		int mana;
 	};
 
-	class OrcMage : public Entity {
+	using RaceStats = std::array<EntityStats, (std::size_t)Role::Count>;
+
+	// Stats of every race and role, indexed by Race then Role. An entity is its stats row plus an id.
+	constexpr std::array<RaceStats, k_builtin_races> k_race_stats = { {
+		//   warior          mage             pet
+		{ { { 90, 20, 0 }, { 40, 30, 120 }, { 170, 10, 5 } } },   // Human
+		{ { { 80, 15, 20 }, { 90, 70, 150 }, { 150, 15, 10 } } }, // Elf
+		{ { { 100, 10, 0 }, { 20, 50, 80 }, { 200, 5, 0 } } }     // Orc
+	} };
+	constexpr std::array<const char*, k_builtin_races> k_race_names = { "human", "elf", "orc" };
+
+	inline Entity make_entity(const EntityStats& stats, int id) {
+		return { id, stats.health, stats.damage, stats.mana };
+	}
+
+	// Built-in races plus the ones loaded from data files.
+	class RaceTable {
+	private:
+		std::vector<std::string> m_names;
+		std::vector<RaceStats> m_stats;
 	public:
-		OrcMage(int id) {
-			this->m_health = 20;
-			this->m_mana = 80;
-			this->m_damage = 50;
-			this->m_id = id;
+		RaceTable() {
+			for (std::size_t race = 0; race < k_builtin_races; race++) add_race(k_race_names[race], k_race_stats[race]);
 		}
-	};
 
-	class OrcPet : public Entity {
-	public:
-		OrcPet(int id) {
-			this->m_health = 200;
-			this->m_mana = 0;
-			this->m_damage = 5;
-			this->m_id = id;
+		std::size_t size() const { return m_stats.size(); }
+		const RaceStats& stats(Race race) const { return m_stats[(std::size_t)race]; }
+		const std::string& name(Race race) const { return m_names[(std::size_t)race]; }
+
+		bool find(std::string_view name, Race& race) const {
+			for (std::size_t i = 0; i < m_names.size(); i++) {
+				if (m_names[i] != name) continue;
+				race = (Race)i;
+				return true;
+			}
+			return false;
 		}
-	};
 
-	class ElfWarior : public Entity {
-	public:
-		ElfWarior(int id) {
-			this->m_health = 80;
-			this->m_mana = 20;
-			this->m_damage = 15;
-			this->m_id = id;
+		// Adding a race that already exists replaces its stats.
+		Race add_race(std::string name, const RaceStats& stats) {
+			Race race;
+			if (find(name, race)) {
+				m_stats[(std::size_t)race] = stats;
+				return race;
+			}
+			if (m_stats.size() > UINT8_MAX) throw std::length_error("Too many races");
+			m_names.push_back(std::move(name));
+			m_stats.push_back(stats);
+			return (Race)(m_stats.size() - 1);
+		}
+
+		// One race per line: name, then health, damage and mana of its warior, mage and pet.
+		// Empty lines and lines starting with '#' are skipped.
+		void load(std::istream& in) {
+			std::string line;
+			for (int line_number = 1; std::getline(in, line); line_number++) {
+				std::istringstream fields(line);
+				std::string name;
+				if (!(fields >> name) || name[0] == '#') continue;
+
+				RaceStats stats;
+				for (auto& role : stats)
+					if (!(fields >> role.health >> role.damage >> role.mana))
+						throw std::invalid_argument("Race data line " + std::to_string(line_number) + ": expected a name and 9 stats");
+				add_race(std::move(name), stats);
+			}
 		}
 	};
 
-	class ElfMage : public Entity {
-	public:
-		ElfMage(int id) {
-			this->m_health = 90;
-			this->m_mana = 150;
-			this->m_damage = 70;
-			this->m_id = id;
+	// Every entity of one (race, role) pair, one contiguous column per component.
+	struct Archetype {
+		std::vector<int> ids;
+		std::vector<int> health;
+		std::vector<int> damage;
+		std::vector<int> mana;
+
+		std::size_t size() const { return ids.size(); }
+		void add(const Entity& entity) {
+			ids.push_back(entity.m_id);
+			health.push_back(entity.m_health);
+			damage.push_back(entity.m_damage);
+			mana.push_back(entity.m_mana);
+		}
+		void reserve(std::size_t count) {
+			ids.reserve(count);
+			health.reserve(count);
+			damage.reserve(count);
+			mana.reserve(count);
 		}
 	};
 
-	class ElfPet : public Entity {
+	// Entity-component store with one archetype per (race, role). Systems stream through the columns they
+	// need instead of chasing a pointer per entity.
+	class World {
+	private:
+		std::vector<Archetype> m_archetypes; // race * Role::Count + role, grows with the races in use
 	public:
-		ElfPet(int id) {
-			this->m_health = 150;
-			this->m_mana = 10;
-			this->m_damage = 15;
-			this->m_id = id;
+		World() : m_archetypes(k_builtin_races * (std::size_t)Role::Count) {}
+
+		Archetype& archetype(Race race, Role role) {
+			std::size_t index = (std::size_t)race * (std::size_t)Role::Count + (std::size_t)role;
+			if (index >= m_archetypes.size()) m_archetypes.resize(((std::size_t)race + 1) * (std::size_t)Role::Count);
+			return m_archetypes[index];
+		}
+		const Archetype& archetype(Race race, Role role) const {
+			static const Archetype empty;
+			std::size_t index = (std::size_t)race * (std::size_t)Role::Count + (std::size_t)role;
+			return index < m_archetypes.size() ? m_archetypes[index] : empty;
+		}
+
+		std::size_t race_count() const { return m_archetypes.size() / (std::size_t)Role::Count; }
+		std::size_t size() const {
+			std::size_t size = 0;
+			for (auto& archetype : m_archetypes) size += archetype.size();
+			return size;
+		}
+
+		// Calls func(archetype) for every race's archetype of the role.
+		template<typename Func>
+		void for_each_archetype(Role role, Func func) const {
+			for (std::size_t race = 0; race < race_count(); race++) func(archetype((Race)race, role));
+		}
+
+		long long total_damage(Role role) const {
+			long long total = 0;
+			for_each_archetype(role, [&](const Archetype& archetype) {
+				for (int damage : archetype.damage) total += damage;
+			});
+			return total;
 		}
 	};
 
-	class HumanWarior : public Entity {
+
+	// Snapshot file: SnapshotHeader, then the entity count of every archetype as uint64, then each archetype's
+	// id, health, damage and mana columns as packed int32, archetypes in World order. Values are stored in the
+	// writer's byte order; the magic number reads differently on a machine of the other order.
+	struct SnapshotHeader {
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t race_count;
+		std::uint32_t role_count;
+		std::uint64_t entity_count;
+	};
+	static_assert(sizeof(SnapshotHeader) == 24, "SnapshotHeader must stay packed");
+	static_assert(sizeof(int) == sizeof(std::int32_t), "Snapshot columns are written as int");
+
+	constexpr std::uint32_t k_snapshot_magic = 0x534C5657; // "WVLS" in little endian
+	constexpr std::uint32_t k_snapshot_version = 1;
+
+	// Writes the world in one sequential pass.
+	inline void save_snapshot(const World& world, const std::string& path) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) throw std::runtime_error("Can't create snapshot " + path);
+
+		const std::size_t races = world.race_count(), roles = (std::size_t)Role::Count;
+		SnapshotHeader header = { k_snapshot_magic, k_snapshot_version, (std::uint32_t)races, (std::uint32_t)roles, world.size() };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (std::size_t race = 0; race < races; race++)
+			for (std::size_t role = 0; role < roles; role++) {
+				std::uint64_t size = world.archetype((Race)race, (Role)role).size();
+				file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+			}
+		for (std::size_t race = 0; race < races; race++)
+			for (std::size_t role = 0; role < roles; role++) {
+				const Archetype& archetype = world.archetype((Race)race, (Role)role);
+				for (const std::vector<int>* column : { &archetype.ids, &archetype.health, &archetype.damage, &archetype.mana })
+					file.write(reinterpret_cast<const char*>(column->data()), (std::streamsize)(column->size() * sizeof(int)));
+			}
+		if (!file.flush()) throw std::runtime_error("Can't write snapshot " + path);
+	}
+
+	// Read-only memory mapping of a whole file.
+	class MappedFile {
+	private:
+		const unsigned char* m_data = nullptr;
+		std::size_t m_size = 0;
+#if defined(_WIN32)
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+#else
+		int m_fd = -1;
+#endif
 	public:
-		HumanWarior(int id) {
-			this->m_health = 90;
-			this->m_mana = 0;
-			this->m_damage = 20;
-			this->m_id = id;
+		explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+			m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			LARGE_INTEGER size;
+			if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size)) {
+				close();
+				throw std::runtime_error("Can't open " + path);
+			}
+			m_size = (std::size_t)size.QuadPart;
+			if (m_size == 0) return;
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping) m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+			m_fd = ::open(path.c_str(), O_RDONLY);
+			struct stat info;
+			if (m_fd < 0 || fstat(m_fd, &info) != 0) {
+				close();
+				throw std::runtime_error("Can't open " + path);
+			}
+			m_size = (std::size_t)info.st_size;
+			if (m_size == 0) return;
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+			if (data != MAP_FAILED) m_data = static_cast<const unsigned char*>(data);
+#endif
+			if (!m_data) {
+				close();
+				throw std::runtime_error("Can't map " + path);
+			}
 		}
+		~MappedFile() { close(); }
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const unsigned char* data() const { return m_data; }
+		std::size_t size() const { return m_size; }
+	private:
+		void close() {
+#if defined(_WIN32)
+			if (m_data) UnmapViewOfFile(m_data);
+			if (m_mapping) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+			m_mapping = nullptr;
+			m_file = INVALID_HANDLE_VALUE;
+#else
+			if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+			if (m_fd >= 0) ::close(m_fd);
+			m_fd = -1;
+#endif
+			m_data = nullptr;
+		}
+	};
+
+	// Columns of one archetype inside a snapshot.
+	struct ArchetypeView {
+		const int* ids = nullptr;
+		const int* health = nullptr;
+		const int* damage = nullptr;
+		const int* mana = nullptr;
+		std::size_t size = 0;
 	};
 
-	class HumanMage : public Entity {
+	// A mapped snapshot. Opening validates the header and the file size once and locates the columns; entities
+	// are never parsed, and systems can read the mapped columns directly.
+	class WorldSnapshot {
+	private:
+		MappedFile m_file;
+		SnapshotHeader m_header;
+		std::vector<ArchetypeView> m_archetypes;
 	public:
-		HumanMage(int id) {
-			this->m_health = 40;
-			this->m_mana = 120;
-			this->m_damage = 30;
-			this->m_id = id;
+		explicit WorldSnapshot(const std::string& path) : m_file(path) {
+			if (m_file.size() < sizeof(SnapshotHeader)) throw std::runtime_error("Snapshot " + path + " is truncated");
+			std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+			if (m_header.magic != k_snapshot_magic) throw std::runtime_error("Snapshot " + path + " has a bad magic number");
+			if (m_header.version != k_snapshot_version) throw std::runtime_error("Snapshot " + path + " has unsupported version " + std::to_string(m_header.version));
+			if (m_header.role_count != (std::uint32_t)Role::Count) throw std::runtime_error("Snapshot " + path + " has a different role set");
+
+			const std::size_t archetypes = (std::size_t)m_header.race_count * m_header.role_count;
+			const std::size_t sizes_end = sizeof(SnapshotHeader) + archetypes * sizeof(std::uint64_t);
+			if (m_file.size() < sizes_end) throw std::runtime_error("Snapshot " + path + " is truncated");
+
+			std::uint64_t total = 0;
+			std::size_t offset = sizes_end;
+			m_archetypes.resize(archetypes);
+			for (std::size_t i = 0; i < archetypes; i++) {
+				std::uint64_t size;
+				std::memcpy(&size, m_file.data() + sizeof(SnapshotHeader) + i * sizeof(std::uint64_t), sizeof(size));
+				if (size > (m_file.size() - offset) / (4 * sizeof(int))) throw std::runtime_error("Snapshot " + path + " is truncated");
+
+				const int* columns = reinterpret_cast<const int*>(m_file.data() + offset);
+				m_archetypes[i] = { columns, columns + size, columns + 2 * size, columns + 3 * size, (std::size_t)size };
+				offset += (std::size_t)size * 4 * sizeof(int);
+				total += size;
+			}
+			if (total != m_header.entity_count || offset != m_file.size()) throw std::runtime_error("Snapshot " + path + " has inconsistent sizes");
+		}
+
+		std::size_t race_count() const { return m_header.race_count; }
+		std::size_t size() const { return (std::size_t)m_header.entity_count; }
+		ArchetypeView archetype(Race race, Role role) const {
+			std::size_t index = (std::size_t)race * (std::size_t)Role::Count + (std::size_t)role;
+			return index < m_archetypes.size() ? m_archetypes[index] : ArchetypeView();
+		}
+
+		// Copies the columns into a regular, modifiable World.
+		World to_world() const {
+			World world;
+			for (std::size_t race = 0; race < race_count(); race++)
+				for (std::size_t role = 0; role < (std::size_t)Role::Count; role++) {
+					ArchetypeView view = archetype((Race)race, (Role)role);
+					Archetype& archetype = world.archetype((Race)race, (Role)role);
+					archetype.ids.assign(view.ids, view.ids + view.size);
+					archetype.health.assign(view.health, view.health + view.size);
+					archetype.damage.assign(view.damage, view.damage + view.size);
+					archetype.mana.assign(view.mana, view.mana + view.size);
+				}
+			return world;
 		}
 	};
 
-	class HumanPet : public Entity {
+
+	class VillageArena;
+
+	// Entity in a VillageArena. Valid until the arena is released, after which the arena rejects it. Other
+	// arenas always reject it.
+	struct ArenaEntity {
+		Entity* entity = nullptr;
+		const VillageArena* arena = nullptr;
+		std::uint32_t epoch = 0;
+	};
+
+	// Monotonic arena for one village's entities. Spawning is a pointer bump, and release() frees every entity
+	// at once by dropping the arena's few chunks, with no per-entity work.
+	class VillageArena {
+	private:
+		std::pmr::monotonic_buffer_resource m_resource{ 64 * 1024 };
+		std::uint32_t m_epoch = 0;
+		std::size_t m_size = 0;
 	public:
-		HumanPet(int id) {
-			this->m_health = 170;
-			this->m_mana = 5;
-			this->m_damage = 10;
-			this->m_id = id;
+		static_assert(std::is_trivially_destructible<Entity>::value, "Arena entities are never destroyed one by one");
+
+		ArenaEntity create(const Entity& entity) {
+			void* storage = m_resource.allocate(sizeof(Entity), alignof(Entity));
+			m_size++;
+			return { new (storage) Entity(entity), this, m_epoch };
 		}
+
+		// nullptr when the handle is from another arena or from before the last release.
+		Entity* get(ArenaEntity handle) const { return handle.arena == this && handle.epoch == m_epoch ? handle.entity : nullptr; }
+
+		void release() {
+			m_resource.release();
+			m_epoch++;
+			m_size = 0;
+		}
+
+		std::size_t size() const { return m_size; }
 	};
 
 
+	// Abstract factory for the entity families of one race. Each family member can be spawned as a shared
+	// entity, as a row of a World archetype, or into a VillageArena.
 	class Vilage {
 	public:
+		virtual ~Vilage() = default;
+
 		virtual std::shared_ptr<Entity> spawn_warior(int id) = 0;
 		virtual std::shared_ptr<Entity> spawn_mage(int id) = 0;
 		virtual std::shared_ptr<Entity> spawn_pet(int id) = 0;
+
+		virtual void spawn_warior(World& world, int id) = 0;
+		virtual void spawn_mage(World& world, int id) = 0;
+		virtual void spawn_pet(World& world, int id) = 0;
+
+		virtual ArenaEntity spawn_warior(VillageArena& arena, int id) = 0;
+		virtual ArenaEntity spawn_mage(VillageArena& arena, int id) = 0;
+		virtual ArenaEntity spawn_pet(VillageArena& arena, int id) = 0;
 	};
 
-	class OrcVilage : public Vilage {
+	// Table-driven village: every family member is a copy of its row in the race's stats, so a race is data
+	// and needs no entity classes. The race villages below and races loaded at startup all build on it.
+	class RaceVilage : public Vilage {
+	private:
+		Race m_race;
+		RaceStats m_stats;
+
+		Entity make(Role role, int id) const { return make_entity(m_stats[(std::size_t)role], id); }
 	public:
-		std::shared_ptr<Entity> spawn_warior(int id) {
-			return std::make_shared<OrcWarior>(id);
-		}
-		std::shared_ptr<Entity> spawn_mage(int id) {
-			return std::make_shared<OrcMage>(id);
-		}
-		std::shared_ptr<Entity> spawn_pet(int id) {
-			return std::make_shared<OrcPet>(id);
-		}
+		RaceVilage(Race race, const RaceStats& stats)
+			: m_race(race), m_stats(stats) {}
+		RaceVilage(const RaceTable& races, Race race)
+			: RaceVilage(race, races.stats(race)) {}
+
+		Race race() const { return m_race; }
+
+		std::shared_ptr<Entity> spawn_warior(int id) override { return std::make_shared<Entity>(make(Role::Warior, id)); }
+		std::shared_ptr<Entity> spawn_mage(int id) override { return std::make_shared<Entity>(make(Role::Mage, id)); }
+		std::shared_ptr<Entity> spawn_pet(int id) override { return std::make_shared<Entity>(make(Role::Pet, id)); }
+
+		void spawn_warior(World& world, int id) override { world.archetype(m_race, Role::Warior).add(make(Role::Warior, id)); }
+		void spawn_mage(World& world, int id) override { world.archetype(m_race, Role::Mage).add(make(Role::Mage, id)); }
+		void spawn_pet(World& world, int id) override { world.archetype(m_race, Role::Pet).add(make(Role::Pet, id)); }
+
+		ArenaEntity spawn_warior(VillageArena& arena, int id) override { return arena.create(make(Role::Warior, id)); }
+		ArenaEntity spawn_mage(VillageArena& arena, int id) override { return arena.create(make(Role::Mage, id)); }
+		ArenaEntity spawn_pet(VillageArena& arena, int id) override { return arena.create(make(Role::Pet, id)); }
 	};
 
-	class ElfVilage : public Vilage {
+	class OrcVilage : public RaceVilage {
 	public:
-		std::shared_ptr<Entity> spawn_warior(int id) {
-			return std::make_shared<ElfWarior>(id);
-		}
-		std::shared_ptr<Entity> spawn_mage(int id) {
-			return std::make_shared<ElfMage>(id);
-		}
-		std::shared_ptr<Entity> spawn_pet(int id) {
-			return std::make_shared<ElfPet>(id);
-		}
+		OrcVilage() 
+			: RaceVilage(Race::Orc, k_race_stats[(std::size_t)Race::Orc]) {}
 	};
 
-	class HumanVilage : public Vilage {
+	class ElfVilage : public RaceVilage {
 	public:
-		std::shared_ptr<Entity> spawn_warior(int id) {
-			return std::make_shared<HumanWarior>(id);
-		}
-		std::shared_ptr<Entity> spawn_mage(int id) {
-			return std::make_shared<HumanMage>(id);
+		ElfVilage() 
+			: RaceVilage(Race::Elf, k_race_stats[(std::size_t)Race::Elf]) {}
+	};
+
+	class HumanVilage : public RaceVilage {
+	public:
+		HumanVilage() 
+			: RaceVilage(Race::Human, k_race_stats[(std::size_t)Race::Human]) {}
+	};
+
+	// Calls the village's family method for a role chosen at runtime. Extra arguments pick the overload:
+	// none for a shared entity, a World or a VillageArena for the other targets.
+	template<typename Village, typename... Target>
+	auto spawn(Village& village, Role role, int id, Target&... target) {
+		switch (role) {
+		case Role::Warior: return village.spawn_warior(target..., id);
+		case Role::Mage: return village.spawn_mage(target..., id);
+		default: return village.spawn_pet(target..., id);
 		}
-		std::shared_ptr<Entity> spawn_pet(int id) {
-			return std::make_shared<HumanPet>(id);
+	}
+
+	// The layout the stat table replaced, kept for the benchmark: one class per (race, role) combination
+	// and one factory override per class.
+	template<int Health, int Damage, int Mana>
+	class ClassEntity : public Entity {
+	public:
+		ClassEntity(int id) {
+			this->m_health = Health;
+			this->m_mana = Mana;
+			this->m_damage = Damage;
+			this->m_id = id;
 		}
 	};
+
+	class ClassVilage {
+	public:
+		virtual ~ClassVilage() = default;
+		virtual std::shared_ptr<Entity> spawn_warior(int id) = 0;
+		virtual std::shared_ptr<Entity> spawn_mage(int id) = 0;
+		virtual std::shared_ptr<Entity> spawn_pet(int id) = 0;
+	};
+
+	template<typename Warior, typename Mage, typename Pet>
+	class ClassRaceVilage : public ClassVilage {
+	public:
+		std::shared_ptr<Entity> spawn_warior(int id) override { return std::make_shared<Warior>(id); }
+		std::shared_ptr<Entity> spawn_mage(int id) override { return std::make_shared<Mage>(id); }
+		std::shared_ptr<Entity> spawn_pet(int id) override { return std::make_shared<Pet>(id); }
+	};
+
+	using ClassHumanVilage = ClassRaceVilage<ClassEntity<90, 20, 0>, ClassEntity<40, 30, 120>, ClassEntity<170, 10, 5>>;
+	using ClassElfVilage = ClassRaceVilage<ClassEntity<80, 15, 20>, ClassEntity<90, 70, 150>, ClassEntity<150, 15, 10>>;
+	using ClassOrcVilage = ClassRaceVilage<ClassEntity<100, 10, 0>, ClassEntity<20, 50, 80>, ClassEntity<200, 5, 0>>;
 }
 
 
@@ -199,5 +552,163 @@ int AbstractFactoryPattern::run() {
 			<< "  health: " + std::to_string(entity->m_health) << "\n";
 	}
 
+	// Races loaded from data at startup spawn like the built-in ones
+	{
+		RaceTable races;
+		std::istringstream data(
+			"# name  warior(health damage mana)  mage(...)  pet(...)\n"
+			"dwarf   120 25 0   60 40 60   140 8 0\n");
+		races.load(data);
+
+		Race dwarf;
+		if (!races.find("dwarf", dwarf)) return 1;
+		RaceVilage dwarf_village(races, dwarf);
+		World world;
+		dwarf_village.spawn_mage(world, 0);
+		auto mage = dwarf_village.spawn_mage(1);
+		std::cout << "\n" << "Loaded races: " << races.size() << ", dwarf mage damage " << mage->m_damage
+			<< ", world mage damage " << world.total_damage(Role::Mage) << std::endl;
+		if (mage->m_damage != 40 || world.total_damage(Role::Mage) != 40) return 1;
+	}
+
+	// Spawn throughput through the factory interfaces: a class per (race, role) combination against the stat
+	// table, as shared entities and as archetype rows
+	{
+		const int count = 3000000;
+		std::vector<std::shared_ptr<ClassVilage>> class_villages = {
+			std::make_shared<ClassHumanVilage>(), std::make_shared<ClassElfVilage>(), std::make_shared<ClassOrcVilage>()
+		};
+		std::vector<std::shared_ptr<Entity>> class_entities;
+		class_entities.reserve(count);
+		double class_ms = benchmark::elapsed_ms([&]() {
+			for (int id = 0; id < count; id++) class_entities.push_back(spawn(*class_villages[id % class_villages.size()], (Role)(id % 3), id));
+		});
+
+		std::vector<std::shared_ptr<Entity>> entities;
+		entities.reserve(count);
+		double shared_ms = benchmark::elapsed_ms([&]() {
+			for (int id = 0; id < count; id++) entities.push_back(spawn(*villages[id % villages.size()], (Role)(id % 3), id));
+		});
+		World world;
+		double world_ms = benchmark::elapsed_ms([&]() {
+			for (int id = 0; id < count; id++) spawn(*villages[id % villages.size()], (Role)(id % 3), id, world);
+		});
+
+		long long class_damage = 0, table_damage = 0;
+		for (int id = 0; id < count; id++) {
+			class_damage += class_entities[id]->m_damage;
+			table_damage += entities[id]->m_damage;
+		}
+		std::cout << "Spawns/sec: class per combination " << count / class_ms * 1000 << ", stat table " << count / shared_ms * 1000
+			<< ", archetype rows " << count / world_ms * 1000 << std::endl;
+		if (class_damage != table_damage || table_damage != world.total_damage(Role::Warior) + world.total_damage(Role::Mage) + world.total_damage(Role::Pet)) return 1;
+	}
+
+	// World build plus teardown at 1M entities: separate shared entities against one arena per village
+	{
+		const int count = 1000000;
+		std::vector<std::shared_ptr<Entity>> entities;
+		double shared_build_ms = benchmark::elapsed_ms([&]() {
+			for (int id = 0; id < count; id++) entities.push_back(spawn(*villages[id % villages.size()], (Role)(id % 3), id));
+		});
+		double shared_teardown_ms = benchmark::elapsed_ms([&]() {
+			entities.clear();
+			entities.shrink_to_fit();
+		});
+
+		std::vector<std::unique_ptr<VillageArena>> arenas;
+		for (std::size_t i = 0; i < villages.size(); i++) arenas.push_back(std::make_unique<VillageArena>());
+		std::vector<ArenaEntity> handles;
+		double arena_build_ms = benchmark::elapsed_ms([&]() {
+			for (int id = 0; id < count; id++) handles.push_back(spawn(*villages[id % villages.size()], (Role)(id % 3), id, *arenas[id % arenas.size()]));
+		});
+		long long arena_damage = 0;
+		for (int id = 0; id < count; id++) arena_damage += arenas[id % arenas.size()]->get(handles[id])->m_damage;
+		ArenaEntity first = handles[0];
+		if (arenas[1]->get(first) != nullptr) return 1; // same epoch, other village's arena
+		double arena_teardown_ms = benchmark::elapsed_ms([&]() {
+			for (auto& arena : arenas) arena->release();
+			handles.clear();
+			handles.shrink_to_fit();
+		});
+
+		std::cout << "\n" << "Build + teardown of " << count << " entities(ms): shared " << shared_build_ms << " + " << shared_teardown_ms
+			<< ", arenas " << arena_build_ms << " + " << arena_teardown_ms << "; stale handle rejected: " << (arenas[0]->get(first) == nullptr) << std::endl;
+		if (arenas[0]->get(first) != nullptr || arena_damage <= 0) return 1;
+	}
+
+	// Query "total damage of all mages" over 10M entities: the mixed entity vector, with roles kept alongside,
+	// against the archetype columns
+	{
+		const int count = 10000000;
+		std::vector<std::shared_ptr<Entity>> entities;
+		std::vector<Role> roles;
+		entities.reserve(count);
+		roles.reserve(count);
+		World world;
+		for (int id = 0; id < count; id++) {
+			Vilage& village = *villages[id % villages.size()];
+			switch ((Role)(id / villages.size() % 3)) {
+			case Role::Warior: entities.push_back(village.spawn_warior(id)); village.spawn_warior(world, id); roles.push_back(Role::Warior); break;
+			case Role::Mage: entities.push_back(village.spawn_mage(id)); village.spawn_mage(world, id); roles.push_back(Role::Mage); break;
+			default: entities.push_back(village.spawn_pet(id)); village.spawn_pet(world, id); roles.push_back(Role::Pet); break;
+			}
+		}
+
+		long long mixed_total = 0, world_total = 0;
+		const int queries = 5;
+		double mixed_ms = benchmark::elapsed_ms([&]() {
+			for (int query = 0; query < queries; query++) {
+				mixed_total = 0;
+				for (std::size_t i = 0; i < entities.size(); i++)
+					if (roles[i] == Role::Mage) mixed_total += entities[i]->m_damage;
+				benchmark::keep((std::size_t)mixed_total);
+			}
+		});
+		double world_ms = benchmark::elapsed_ms([&]() {
+			for (int query = 0; query < queries; query++) {
+				world_total = world.total_damage(Role::Mage);
+				benchmark::keep((std::size_t)world_total);
+			}
+		});
+		std::cout << "\n" << "Mage damage over " << world.size() << " entities: " << world_total << ", mixed vector " << mixed_ms / queries
+			<< " ms/query, archetypes " << world_ms / queries << " ms/query" << std::endl;
+		if (mixed_total != world_total) return 1;
+		entities.clear();
+		entities.shrink_to_fit();
+
+		// Warm restart: save the world, then map it back instead of spawning again
+		std::string path;
+		double save_ms = 0, map_ms = 0, copy_ms = 0, megabytes = 0;
+		long long mapped_total = 0, loaded_total = 0;
+		try {
+			path = (std::filesystem::temp_directory_path() / "patterns_world.snapshot").string();
+			save_ms = benchmark::elapsed_ms([&]() { save_snapshot(world, path); });
+			megabytes = (double)std::filesystem::file_size(path) / (1024 * 1024);
+
+			std::unique_ptr<WorldSnapshot> snapshot;
+			map_ms = benchmark::elapsed_ms([&]() { snapshot = std::make_unique<WorldSnapshot>(path); });
+			for (std::size_t race = 0; race < snapshot->race_count(); race++) {
+				ArchetypeView mages = snapshot->archetype((Race)race, Role::Mage);
+				for (std::size_t i = 0; i < mages.size; i++) mapped_total += mages.damage[i];
+			}
+			World loaded;
+			copy_ms = benchmark::elapsed_ms([&]() { loaded = snapshot->to_world(); });
+			loaded_total = loaded.total_damage(Role::Mage);
+		}
+		catch (const std::exception& error) {
+			std::cout << "Snapshot failed: " << error.what() << std::endl;
+			std::error_code ignored;
+			if (!path.empty()) std::filesystem::remove(path, ignored);
+			return 1;
+		}
+		std::error_code ignored;
+		std::filesystem::remove(path, ignored);
+
+		std::cout << "Snapshot of " << megabytes << " MB: save " << save_ms << " ms(" << megabytes / save_ms * 1000 << " MB/s), map "
+			<< map_ms << " ms, copy into a World " << copy_ms << " ms(" << megabytes / copy_ms * 1000 << " MB/s)" << std::endl;
+		if (mapped_total != world_total || loaded_total != world_total) return 1;
+	}
+
 	return 0;
 }
\ No newline at end of file
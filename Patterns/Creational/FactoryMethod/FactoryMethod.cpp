@@ -1,5 +1,17 @@
 #include "FactoryMethod.h"
+#include "../../Benchmark.h"
+#include "../../PerfectHash.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 
@@ -16,54 +28,432 @@ namespace factory_method {
 
 	class Spider : public Entity {
 	public:
+		static constexpr int k_health = 5, k_damage = 2;
 		Spider(int id) 
-			: Entity(id, 5, 2) {}
+			: Entity(id, k_health, k_damage) {}
 	};
 
 	class Sheep : public Entity {
 	public:
+		static constexpr int k_health = 10, k_damage = 0;
 		Sheep(int id)
-			: Entity(id, 10, 0) {}
+			: Entity(id, k_health, k_damage) {}
 	};
 
 	class Warior : public Entity {
 	public:
+		static constexpr int k_health = 100, k_damage = 10;
 		Warior(int id) : 
-			Entity(id, 100, 10) {}
+			Entity(id, k_health, k_damage) {}
 	};
 
+	// Structure-of-arrays batch of entities: entity i is (ids[i], health[i], damage[i]).
+	struct EntityBlock {
+		std::vector<int> ids;
+		std::vector<int> health;
+		std::vector<int> damage;
+
+		std::size_t size() const { return ids.size(); }
+		void clear() {
+			ids.clear();
+			health.clear();
+			damage.clear();
+		}
+	};
+
+	// Appends count entities of type T with consecutive ids. Each column is filled by its own plain loop so the
+	// compiler vectorizes all three.
+	template<typename T>
+	void fill_block(EntityBlock& block, std::size_t count, int first_id) {
+		const std::size_t offset = block.size();
+		block.ids.resize(offset + count);
+		block.health.resize(offset + count);
+		block.damage.resize(offset + count);
+
+		int* ids = block.ids.data() + offset;
+		for (std::size_t i = 0; i < count; i++) ids[i] = first_id + (int)i;
+		std::fill_n(block.health.data() + offset, count, T::k_health);
+		std::fill_n(block.damage.data() + offset, count, T::k_damage);
+	}
+
+
+	// Free lists of equally sized blocks carved from aligned chunks. A block finds its chunk by masking its
+	// address, so a chunk whose blocks are all released goes back to the system. One empty chunk is kept to
+	// absorb spawn/despawn churn. allocate and deallocate lock the pool, so entities can be created and dropped
+	// on any thread.
+	class BlockPool {
+	private:
+		static constexpr std::size_t k_chunk_bytes = 64 * 1024;
+		struct Chunk {
+			void* free = nullptr;
+			std::size_t in_use = 0;
+			std::size_t index = 0; // position in m_chunks
+			std::size_t available_index = 0; // position in m_available while the chunk has free blocks
+		};
+		static constexpr std::size_t k_header = (sizeof(Chunk) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+		mutable std::mutex m_mutex;
+		std::atomic<std::size_t> m_block_size{ 0 };
+		std::size_t m_blocks_per_chunk = 0;
+		std::vector<Chunk*> m_chunks;
+		std::vector<Chunk*> m_available; // allocation takes the last one
+		std::size_t m_empty_chunks = 0;
+		std::size_t m_in_use = 0;
+
+		static Chunk* chunk_of(void* block) {
+			return reinterpret_cast<Chunk*>(reinterpret_cast<std::uintptr_t>(block) & ~(std::uintptr_t)(k_chunk_bytes - 1));
+		}
+
+		void grow() {
+			Chunk* chunk = new (::operator new(k_chunk_bytes, std::align_val_t(k_chunk_bytes))) Chunk();
+			unsigned char* blocks = reinterpret_cast<unsigned char*>(chunk) + k_header;
+			const std::size_t block_size = m_block_size.load(std::memory_order_relaxed);
+			for (std::size_t i = m_blocks_per_chunk; i-- > 0;) {
+				void* block = blocks + i * block_size;
+				*static_cast<void**>(block) = chunk->free;
+				chunk->free = block;
+			}
+			chunk->index = m_chunks.size();
+			m_chunks.push_back(chunk);
+			chunk->available_index = m_available.size();
+			m_available.push_back(chunk);
+			m_empty_chunks++;
+		}
+
+		void release(Chunk* chunk) {
+			Chunk* moved = m_available.back();
+			m_available[chunk->available_index] = moved;
+			moved->available_index = chunk->available_index;
+			m_available.pop_back();
+
+			moved = m_chunks.back();
+			m_chunks[chunk->index] = moved;
+			moved->index = chunk->index;
+			m_chunks.pop_back();
+
+			m_empty_chunks--;
+			chunk->~Chunk();
+			::operator delete(chunk, std::align_val_t(k_chunk_bytes));
+		}
+	public:
+		BlockPool() = default;
+		BlockPool(const BlockPool&) = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+		~BlockPool() {
+			for (Chunk* chunk : m_chunks) {
+				chunk->~Chunk();
+				::operator delete(chunk, std::align_val_t(k_chunk_bytes));
+			}
+		}
+
+		// The first allocation fixes the block size, other sizes are refused with nullptr.
+		void* allocate(std::size_t size) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::size_t block_size = m_block_size.load(std::memory_order_relaxed);
+			if (block_size == 0) {
+				const std::size_t align = alignof(std::max_align_t);
+				block_size = (std::max(size, sizeof(void*)) + align - 1) / align * align;
+				m_blocks_per_chunk = (k_chunk_bytes - k_header) / block_size;
+				m_block_size.store(block_size, std::memory_order_relaxed);
+			}
+			if (size > block_size || m_blocks_per_chunk == 0) return nullptr;
+			if (m_available.empty()) grow();
+
+			Chunk* chunk = m_available.back();
+			if (chunk->in_use++ == 0) m_empty_chunks--;
+			void* block = chunk->free;
+			chunk->free = *static_cast<void**>(block);
+			if (!chunk->free) m_available.pop_back();
+			m_in_use++;
+			return block;
+		}
+		void deallocate(void* block) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Chunk* chunk = chunk_of(block);
+			if (!chunk->free) {
+				chunk->available_index = m_available.size();
+				m_available.push_back(chunk);
+			}
+			*static_cast<void**>(block) = chunk->free;
+			chunk->free = block;
+			m_in_use--;
+			if (--chunk->in_use == 0 && ++m_empty_chunks > 1) release(chunk);
+		}
+
+		// 0 until the first allocation, the size of every pooled block after it.
+		std::size_t block_size() const { return m_block_size.load(std::memory_order_relaxed); }
+		std::size_t in_use() const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_in_use;
+		}
+		std::size_t capacity() const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_chunks.size() * m_blocks_per_chunk;
+		}
+	};
+
+	// Pool shared by every spawner of entity type T for the lifetime of the program.
+	template<typename T>
+	BlockPool& entity_pool() {
+		static BlockPool pool;
+		return pool;
+	}
+
+	// Routes allocate_shared through a BlockPool, so the entity and its control block share one pooled block.
+	template<typename T>
+	struct PoolAllocator {
+		using value_type = T;
+		BlockPool* m_pool;
+
+		PoolAllocator(BlockPool& pool) : m_pool(&pool) {}
+		template<typename U> PoolAllocator(const PoolAllocator<U>& other) : m_pool(other.m_pool) {}
+
+		T* allocate(std::size_t n) {
+			if (n == 1)
+				if (void* block = m_pool->allocate(sizeof(T))) return static_cast<T*>(block);
+			return std::allocator<T>().allocate(n);
+		}
+		void deallocate(T* p, std::size_t n) {
+			if (n == 1 && sizeof(T) <= m_pool->block_size()) m_pool->deallocate(p);
+			else std::allocator<T>().deallocate(p, n);
+		}
+
+		template<typename U> bool operator==(const PoolAllocator<U>& other) const { return m_pool == other.m_pool; }
+		template<typename U> bool operator!=(const PoolAllocator<U>& other) const { return m_pool != other.m_pool; }
+	};
+
+	template<typename T>
+	std::shared_ptr<Entity> make_pooled(int id) {
+		return std::allocate_shared<T>(PoolAllocator<T>(entity_pool<T>()), id);
+	}
+
+	// Handle to a spawned entity. The generation changes every time the id is recycled, so a handle kept
+	// after its entity was despawned is detected as stale.
+	struct EntityHandle {
+		int id = -1;
+		std::uint32_t generation = 0;
+	};
+
+	// Hands out entity ids, reusing released ones before growing. Safe to use from several threads, entities
+	// release their ids from whichever thread drops the last reference.
+	class EntityIds {
+	private:
+		mutable std::mutex m_mutex;
+		std::vector<std::uint32_t> m_generations;
+		std::vector<int> m_free;
+	public:
+		EntityHandle acquire() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_free.empty()) {
+				m_generations.push_back(0);
+				return { (int)m_generations.size() - 1, 0 };
+			}
+			int id = m_free.back();
+			m_free.pop_back();
+			return { id, m_generations[id] };
+		}
+
+		// Releasing a stale handle does nothing.
+		void release(EntityHandle handle) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!is_current(handle)) return;
+			m_generations[handle.id]++;
+			m_free.push_back(handle.id);
+		}
+
+		bool alive(EntityHandle handle) const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return is_current(handle);
+		}
+
+		std::size_t issued() const {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_generations.size();
+		}
+	private:
+		bool is_current(EntityHandle handle) const {
+			return handle.id >= 0 && (std::size_t)handle.id < m_generations.size() && m_generations[handle.id] == handle.generation;
+		}
+	};
+
+	// Entity of type T whose id goes back to its EntityIds when the last reference is dropped.
+	template<typename T>
+	class Recycled : public T {
+	private:
+		std::shared_ptr<EntityIds> m_ids;
+		std::uint32_t m_generation;
+	public:
+		Recycled(EntityHandle handle, std::shared_ptr<EntityIds> ids)
+			: T(handle.id), m_ids(std::move(ids)), m_generation(handle.generation) {}
+		~Recycled() { m_ids->release({ this->m_id, m_generation }); }
+
+		EntityHandle handle() const { return { this->m_id, m_generation }; }
+	};
+
+	// Pooled entity with an id from ids. handle receives the entity's handle when not null.
+	template<typename T>
+	std::shared_ptr<Entity> make_recycled(const std::shared_ptr<EntityIds>& ids, EntityHandle* handle) {
+		auto entity = std::allocate_shared<Recycled<T>>(PoolAllocator<Recycled<T>>(entity_pool<Recycled<T>>()), ids->acquire(), ids);
+		if (handle) *handle = entity->handle();
+		return entity;
+	}
+
 
 	class Spawner {
 	private:
 	protected:
 		virtual std::shared_ptr<Entity> spawn(int id) = 0;
+		virtual std::shared_ptr<Entity> spawn(const std::shared_ptr<EntityIds>& ids, EntityHandle* handle) = 0;
+		virtual void spawn_block(EntityBlock& block, std::size_t count, int first_id) = 0;
 
 	public:
 		std::shared_ptr<Entity> create(int id) {
 			return spawn(id);
 		}
+		// Takes a recycled id from ids, released again when the entity is gone.
+		std::shared_ptr<Entity> create(const std::shared_ptr<EntityIds>& ids, EntityHandle* handle = nullptr) {
+			return spawn(ids, handle);
+		}
+
+		// Spawns count entities with ids first_id, first_id + 1, ... in one call.
+		EntityBlock spawn_n(std::size_t count, int first_id) {
+			EntityBlock block;
+			spawn_block(block, count, first_id);
+			return block;
+		}
+		// Same, appending to an existing block so its storage is reused.
+		void spawn_n(std::size_t count, int first_id, EntityBlock& block) {
+			spawn_block(block, count, first_id);
+		}
 	};
 
+	// Spawners allocate from the pool of their entity type. Entities return to it when their last reference goes away,
+	// and entities spawned with an EntityIds give their id back at the same time.
 	class SpiderSpawner : public Spawner {
 	public:
 		std::shared_ptr<Entity> spawn(int id) {
-			return std::make_shared<Spider>(id);
+			return make_pooled<Spider>(id);
 		};
+		std::shared_ptr<Entity> spawn(const std::shared_ptr<EntityIds>& ids, EntityHandle* handle) {
+			return make_recycled<Spider>(ids, handle);
+		}
+		void spawn_block(EntityBlock& block, std::size_t count, int first_id) {
+			fill_block<Spider>(block, count, first_id);
+		}
 	};
 
 	class SheepSpawner : public Spawner {
 	public:
 		std::shared_ptr<Entity> spawn(int id) {
-			return std::make_shared<Sheep>(id);
+			return make_pooled<Sheep>(id);
 		};
+		std::shared_ptr<Entity> spawn(const std::shared_ptr<EntityIds>& ids, EntityHandle* handle) {
+			return make_recycled<Sheep>(ids, handle);
+		}
+		void spawn_block(EntityBlock& block, std::size_t count, int first_id) {
+			fill_block<Sheep>(block, count, first_id);
+		}
 	};
 
 	class WariorSpawner : public Spawner {
 	public:
 		std::shared_ptr<Entity> spawn(int id) {
-			return std::make_shared<Warior>(id);
+			return make_pooled<Warior>(id);
 		};
+		std::shared_ptr<Entity> spawn(const std::shared_ptr<EntityIds>& ids, EntityHandle* handle) {
+			return make_recycled<Warior>(ids, handle);
+		}
+		void spawn_block(EntityBlock& block, std::size_t count, int first_id) {
+			fill_block<Warior>(block, count, first_id);
+		}
+	};
+
+
+	// Registry of spawnable types: a constexpr table of constructor thunks indexed by EntityType, so spawning by
+	// type needs neither a spawner object nor a virtual call. A new type is one enum value and one table row.
+	enum class EntityType : std::uint8_t { Spider, Sheep, Warior };
+
+	struct SpawnEntry {
+		std::string_view name;
+		EntityType type;
+		std::shared_ptr<Entity>(*create)(int id);
+		void(*create_block)(EntityBlock& block, std::size_t count, int first_id);
 	};
+
+	constexpr std::array<SpawnEntry, 3> k_spawn_registry = { {
+		{ "spider", EntityType::Spider, &make_pooled<Spider>, &fill_block<Spider> },
+		{ "sheep", EntityType::Sheep, &make_pooled<Sheep>, &fill_block<Sheep> },
+		{ "warior", EntityType::Warior, &make_pooled<Warior>, &fill_block<Warior> }
+	} };
+
+	constexpr bool registry_in_type_order() {
+		for (std::size_t i = 0; i < k_spawn_registry.size(); i++)
+			if ((std::size_t)k_spawn_registry[i].type != i) return false;
+		return true;
+	}
+	static_assert(registry_in_type_order(), "k_spawn_registry rows must follow EntityType order");
+
+	inline std::shared_ptr<Entity> spawn(EntityType type, int id) {
+		return k_spawn_registry[(std::size_t)type].create(id);
+	}
+
+	// Perfect hash over the registry names, its seed searched at compile time. The build fails if no seed
+	// separates the names.
+	constexpr auto k_spawn_name_hash = perfect_hash::build<8>(k_spawn_registry, [](const SpawnEntry& entry) { return entry.name; });
+
+	// Registry row for a type name read from config, nullptr when the name is unknown.
+	inline const SpawnEntry* find_spawn_entry(std::string_view name) {
+		int row = k_spawn_name_hash.row(name);
+		if (row >= 0 && k_spawn_registry[row].name == name) return &k_spawn_registry[row];
+		return nullptr;
+	}
+
+
+	// Id source shared by the workers of a parallel spawn. Workers reserve a range at a time, so the shared
+	// counter is touched once per block instead of once per entity.
+	class IdBlockAllocator {
+	private:
+		std::atomic<int> m_next{ 0 };
+	public:
+		// First id of a fresh range of count ids.
+		int reserve(int count) { return m_next.fetch_add(count, std::memory_order_relaxed); }
+		int issued() const { return m_next.load(std::memory_order_relaxed); }
+	};
+
+	// Spawns count entities of one type on worker threads. Each worker fills its own block with id ranges of
+	// id_block reserved from ids, and the blocks are merged once all workers are done. A thread count or
+	// id_block below one is treated as one.
+	inline EntityBlock parallel_spawn(EntityType type, std::size_t count, unsigned threads, IdBlockAllocator& ids, int id_block = 4096) {
+		threads = std::max(threads, 1u);
+		id_block = std::max(id_block, 1);
+		const SpawnEntry& entry = k_spawn_registry[(std::size_t)type];
+		std::vector<EntityBlock> local(threads);
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threads; t++) {
+			std::size_t share = count / threads + (t < count % threads ? 1 : 0);
+			workers.emplace_back([&entry, &ids, &block = local[t], share, id_block]() {
+				block.ids.reserve(share);
+				block.health.reserve(share);
+				block.damage.reserve(share);
+				while (block.size() < share) {
+					int chunk = (int)std::min(share - block.size(), (std::size_t)id_block);
+					entry.create_block(block, chunk, ids.reserve(chunk));
+				}
+			});
+		}
+		for (auto& worker : workers) worker.join();
+
+		EntityBlock merged;
+		merged.ids.reserve(count);
+		merged.health.reserve(count);
+		merged.damage.reserve(count);
+		for (auto& block : local) {
+			merged.ids.insert(merged.ids.end(), block.ids.begin(), block.ids.end());
+			merged.health.insert(merged.health.end(), block.health.begin(), block.health.end());
+			merged.damage.insert(merged.damage.end(), block.damage.begin(), block.damage.end());
+		}
+		return merged;
+	}
 }
 
 
@@ -106,6 +496,184 @@ int FactoryMethodPattern::run() {
 		<< "  health: " + std::to_string(entity->m_health) << "\n";
 	}
 
+	// Despawned entities give their id back with a new generation, handles to them are stale
+	{
+		auto ids = std::make_shared<EntityIds>();
+		SheepSpawner spawner;
+		EntityHandle first, reused;
+		std::shared_ptr<Entity> sheep = spawner.create(ids, &first);
+		sheep.reset();
+		sheep = spawner.create(ids, &reused);
+		std::cout << "\n" << "Recycled id " << reused.id << " generation " << reused.generation
+			<< ", old handle alive: " << ids->alive(first) << std::endl;
+		if (reused.id != first.id || ids->alive(first) || !ids->alive(reused)) return 1;
+	}
+
+	// Churn: a live population of 10K where every step despawns one entity and spawns a replacement.
+	// Only the allocation path is timed, both sides replace the entity in place with a plain counter id
+	{
+		const std::size_t live = 10000, steps = 1000000;
+
+		std::vector<std::shared_ptr<Entity>> heap_population(live);
+		double heap_ms = benchmark::elapsed_ms([&]() {
+			int next_id = 0;
+			for (std::size_t i = 0; i < steps; i++) {
+				std::size_t slot = (i * 7919) % live;
+				heap_population[slot] = std::make_shared<Spider>(next_id++);
+			}
+		});
+
+		std::vector<std::shared_ptr<Entity>> pooled_population(live);
+		double pooled_ms = benchmark::elapsed_ms([&]() {
+			int next_id = 0;
+			for (std::size_t i = 0; i < steps; i++) {
+				std::size_t slot = (i * 7919) % live;
+				pooled_population[slot] = make_pooled<Spider>(next_id++);
+			}
+		});
+
+		std::cout << "Churn(" << steps << " spawn/despawn pairs): make_shared " << steps / heap_ms * 1000 << "/sec, pooled "
+			<< steps / pooled_ms * 1000 << "/sec, pool blocks " << entity_pool<Spider>().capacity() << std::endl;
+
+		// The same churn through a spawner with recycled ids never issues more ids than the live population
+		SpiderSpawner spawner;
+		auto ids = std::make_shared<EntityIds>();
+		std::vector<std::shared_ptr<Entity>> population(live);
+		for (std::size_t i = 0; i < steps; i++) {
+			std::size_t slot = (i * 7919) % live;
+			population[slot].reset();
+			population[slot] = spawner.create(ids);
+		}
+		std::cout << "Churn with recycled ids: " << ids->issued() << " ids issued for " << live << " live entities" << std::endl;
+		if (ids->issued() != live) return 1;
+
+		// Spawning and despawning on several threads at once, every block must be back in the pool afterwards
+		const std::size_t spiders_before = entity_pool<Spider>().in_use();
+		std::vector<std::thread> workers;
+		for (int t = 0; t < 4; t++) {
+			workers.emplace_back([&spawner, ids]() {
+				std::vector<std::shared_ptr<Entity>> local(64);
+				for (std::size_t i = 0; i < 100000; i++) {
+					local[i % local.size()] = spawner.create((int)i);
+					if (i % 3 == 0) local[(i * 7) % local.size()] = spawner.create(ids);
+				}
+			});
+		}
+		for (auto& worker : workers) worker.join();
+		if (entity_pool<Spider>().in_use() != spiders_before) return 1;
+	}
+
+	// Bulk spawning: 10M entities through one spawn_n call per spawner against one virtual create per entity
+	{
+		const std::size_t count = 10000000;
+		const std::size_t per_spawner = count / world_spawners.size();
+
+		std::vector<std::shared_ptr<Entity>> entities;
+		double single_ms = benchmark::elapsed_ms([&]() {
+			entities.reserve(count);
+			int id = 0;
+			for (auto& spawner : world_spawners)
+				for (std::size_t i = 0; i < per_spawner; i++) entities.push_back(spawner->create(id++));
+		});
+
+		EntityBlock block;
+		double bulk_ms = benchmark::elapsed_ms([&]() {
+			block.ids.reserve(count);
+			block.health.reserve(count);
+			block.damage.reserve(count);
+			int id = 0;
+			for (auto& spawner : world_spawners) {
+				spawner->spawn_n(per_spawner, id, block);
+				id += (int)per_spawner;
+			}
+		});
+
+		double reuse_ms = benchmark::elapsed_ms([&]() {
+			block.clear();
+			int id = 0;
+			for (auto& spawner : world_spawners) {
+				spawner->spawn_n(per_spawner, id, block);
+				id += (int)per_spawner;
+			}
+		});
+
+		bool same = block.size() == entities.size();
+		for (std::size_t i = 0; same && i < block.size(); i += 9973)
+			same = block.ids[i] == entities[i]->m_id && block.health[i] == entities[i]->m_health && block.damage[i] == entities[i]->m_damage;
+		std::cout << "\n" << "Spawning " << block.size() << " entities: per-entity create " << single_ms << " ms, spawn_n " << bulk_ms << " ms, spawn_n into a reused block " << reuse_ms << " ms" << std::endl;
+		if (!same) return 1;
+
+		// Chunks emptied by the despawn go back to the system instead of staying pinned in the pool
+		const std::size_t spider_blocks = entity_pool<Spider>().capacity();
+		entities = std::vector<std::shared_ptr<Entity>>();
+		std::cout << "Spider pool after despawning: " << spider_blocks << " -> " << entity_pool<Spider>().capacity() << " blocks" << std::endl;
+		if (entity_pool<Spider>().capacity() >= spider_blocks) return 1;
+	}
+
+	// Spawning by type name through the registry against a name -> virtual spawner map
+	{
+		const std::vector<std::string> config_names = { "spider", "sheep", "warior", "spider", "dragon" };
+		const SpawnEntry* dragon = find_spawn_entry("dragon");
+		auto sheep = spawn(EntityType::Sheep, 0);
+		std::cout << "\n" << "Registry: " << k_spawn_registry.size() << " types, sheep health " << sheep->m_health
+			<< ", unknown name found: " << (dragon != nullptr) << std::endl;
+		if (dragon || sheep->m_health != Sheep::k_health) return 1;
+
+		std::unordered_map<std::string, std::shared_ptr<Spawner>> spawners_by_name = {
+			{ "spider", world_spawners[0] }, { "sheep", world_spawners[2] }, { "warior", world_spawners[3] }
+		};
+
+		const std::size_t spawns = 1000000;
+		double virtual_ns = benchmark::ns_per_op(spawns, [&](std::size_t i) {
+			auto found = spawners_by_name.find(config_names[i % config_names.size()]);
+			if (found != spawners_by_name.end()) benchmark::keep(found->second->create((int)i)->m_health);
+		});
+		double registry_ns = benchmark::ns_per_op(spawns, [&](std::size_t i) {
+			if (const SpawnEntry* entry = find_spawn_entry(config_names[i % config_names.size()])) benchmark::keep(entry->create((int)i)->m_health);
+		});
+		double map_lookup_ns = benchmark::ns_per_op(spawns, [&](std::size_t i) {
+			benchmark::keep(spawners_by_name.count(config_names[i % config_names.size()]));
+		});
+		double registry_lookup_ns = benchmark::ns_per_op(spawns, [&](std::size_t i) {
+			benchmark::keep((std::size_t)find_spawn_entry(config_names[i % config_names.size()]));
+		});
+		std::cout << "Lookup + spawn(ns): virtual spawner map " << virtual_ns << ", registry " << registry_ns
+			<< "; lookup only: map " << map_lookup_ns << ", registry " << registry_lookup_ns << std::endl;
+	}
+
+	// Parallel spawning: wall time to spawn and merge the warriors, thread start-up included, per thread count.
+	// Every thread count must produce unique ids
+	{
+		auto unique_ids = [](const EntityBlock& block, const IdBlockAllocator& ids, std::size_t expected) {
+			std::vector<bool> seen(ids.issued());
+			bool unique = block.size() == expected;
+			for (std::size_t i = 0; unique && i < block.size(); i++) {
+				unique = !seen[block.ids[i]];
+				seen[block.ids[i]] = true;
+			}
+			return unique;
+		};
+
+		// Zero threads and an empty id block are clamped to one, not divided by
+		IdBlockAllocator clamped_ids;
+		if (!unique_ids(parallel_spawn(EntityType::Warior, 1000, 0, clamped_ids, 0), clamped_ids, 1000)) return 1;
+
+		const std::size_t count = 4000000;
+		std::cout << "\n" << "Parallel spawn of " << count << " warriors(ms, " << std::thread::hardware_concurrency() << " hardware threads):";
+		for (unsigned threads : { 1u, 2u, 4u, 8u, 16u, 32u }) {
+			IdBlockAllocator ids;
+			EntityBlock block;
+			double ms = benchmark::elapsed_ms([&]() { block = parallel_spawn(EntityType::Warior, count, threads, ids); });
+
+			std::cout << " " << threads << "t " << ms;
+			if (!unique_ids(block, ids, count)) {
+				std::cout << std::endl << "Duplicate or missing ids with " << threads << " threads" << std::endl;
+				return 1;
+			}
+		}
+		std::cout << std::endl;
+	}
+
 	return 0;
 }
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Compile-time perfect hash for the constexpr name tables of the pattern demos.
+namespace perfect_hash {
+
+	// FNV-1a over the whole name, the seed mixed into the offset basis.
+	constexpr std::uint32_t name_hash(std::string_view name, std::uint32_t seed) {
+		std::uint32_t hash = 2166136261u ^ seed;
+		for (char c : name) {
+			hash ^= (std::uint8_t)c;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	// Gives every name of one table its own slot. A slot only says which row to compare against, so callers
+	// still compare the name to reject unknown ones.
+	template<std::size_t Slots>
+	struct Table {
+		static constexpr std::size_t k_slots = Slots;
+		std::uint32_t seed = 0;
+		std::array<std::int16_t, Slots> rows{}; // row in the source table, -1 when empty
+
+		// Candidate row for name, -1 when it can't be in the table.
+		constexpr int row(std::string_view name) const { return rows[name_hash(name, seed) % Slots]; }
+	};
+
+	// Searches the first max_seeds seeds for one without collisions. When used to initialize a constexpr
+	// table, running out of seeds reaches the throw and fails the build.
+	template<std::size_t Slots, typename Row, std::size_t N, typename NameOf>
+	constexpr Table<Slots> build(const std::array<Row, N>& table, NameOf name_of, std::uint32_t max_seeds = 4096) {
+		static_assert(N <= Slots && Slots <= 32767, "Perfect hash needs at least one slot per row");
+		for (std::uint32_t seed = 0; seed < max_seeds; seed++) {
+			Table<Slots> hash;
+			hash.seed = seed;
+			for (auto& row : hash.rows) row = -1;
+
+			bool collision = false;
+			for (std::size_t i = 0; i < N && !collision; i++) {
+				std::size_t slot = name_hash(name_of(table[i]), seed) % Slots;
+				if (hash.rows[slot] != -1) collision = true;
+				else hash.rows[slot] = (std::int16_t)i;
+			}
+			if (!collision) return hash;
+		}
+		throw "no collision-free seed for the table names";
+	}
+}
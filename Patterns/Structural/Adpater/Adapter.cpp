@@ -1,79 +1,343 @@
 #include "Adapter.h"
+#include "../../Benchmark.h"
+#include "../../PerfectHash.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 
 namespace adapter_pattern {
 
+	struct RegionEntry {
+		std::string_view name;
+		int id;
+		std::string_view weather;
+	};
+
+	// Regions known at build time. A region's id is its position in the table plus one.
+	constexpr std::array<RegionEntry, 4> k_known_regions = { {
+		{ "eu_east", 1, "Weather is Good)" },
+		{ "eu_west", 2, "Weather is Okey)" },
+		{ "us_east", 3, "Weather is Fine)" },
+		{ "us_west", 4, "Weather is Great)" }
+	} };
+
+	// Perfect hash over k_known_regions, its seed searched at compile time.
+	constexpr auto k_region_hash = perfect_hash::build<8>(k_known_regions, [](const RegionEntry& region) { return region.name; });
+
+	// Open-addressing name -> id table for regions registered at runtime.
+	class FlatRegionTable {
+	private:
+		struct Slot {
+			std::string name;
+			int id = 0; // 0 marks an empty slot
+		};
+		std::vector<Slot> m_slots;
+		std::size_t m_size = 0;
+
+		void grow() {
+			std::vector<Slot> old_slots = std::move(m_slots);
+			m_slots.assign(old_slots.empty() ? 16 : old_slots.size() * 2, Slot());
+			m_size = 0;
+			for (auto& slot : old_slots)
+				if (slot.id) insert(std::move(slot.name), slot.id);
+		}
+	public:
+		int find(std::string_view name) const {
+			if (m_slots.empty()) return 0;
+			const std::size_t mask = m_slots.size() - 1;
+			for (std::size_t i = perfect_hash::name_hash(name, 0) & mask;; i = (i + 1) & mask) {
+				if (m_slots[i].id == 0) return 0;
+				if (m_slots[i].name == name) return m_slots[i].id;
+			}
+		}
+
+		void insert(std::string name, int id) {
+			if ((m_size + 1) * 2 > m_slots.size()) grow();
+			const std::size_t mask = m_slots.size() - 1;
+			std::size_t i = perfect_hash::name_hash(name, 0) & mask;
+			while (m_slots[i].id != 0) i = (i + 1) & mask;
+			m_slots[i] = { std::move(name), id };
+			m_size++;
+		}
+	};
+
+	// Region name <-> id <-> weather lookups. Names are compared by content: known regions go through the
+	// compile-time perfect hash, regions added at runtime through the flat fallback table.
+	// Weather objects share one immutable directory, so constructing them builds no tables.
+	class RegionDirectory {
+	private:
+		struct RuntimeRegion {
+			std::string name;
+			std::string weather;
+		};
+		FlatRegionTable m_runtime_ids;
+		std::vector<RuntimeRegion> m_runtime_regions; // id = k_known_regions.size() + 1 + index
+	public:
+		// 0 when the region is unknown.
+		int id_of(std::string_view name) const {
+			int known = k_region_hash.row(name);
+			if (known >= 0 && k_known_regions[known].name == name) return k_known_regions[known].id;
+			return m_runtime_ids.find(name);
+		}
+
+		// Null-terminated name, empty when the id is unknown.
+		const char* name_of(int id) const {
+			if (id >= 1 && id <= (int)k_known_regions.size()) return k_known_regions[id - 1].name.data();
+			std::size_t index = (std::size_t)id - k_known_regions.size() - 1;
+			if (id > 0 && index < m_runtime_regions.size()) return m_runtime_regions[index].name.c_str();
+			return "";
+		}
+
+		std::string_view weather_of(int id) const {
+			if (id >= 1 && id <= (int)k_known_regions.size()) return k_known_regions[id - 1].weather;
+			std::size_t index = (std::size_t)id - k_known_regions.size() - 1;
+			if (id > 0 && index < m_runtime_regions.size()) return m_runtime_regions[index].weather;
+			return {};
+		}
+
+		// Returns the region's id, registering it first if it is new.
+		int add_region(std::string name, std::string weather) {
+			if (int id = id_of(name)) return id;
+			int id = (int)(k_known_regions.size() + m_runtime_regions.size() + 1);
+			m_runtime_ids.insert(name, id);
+			m_runtime_regions.push_back({ std::move(name), std::move(weather) });
+			return id;
+		}
+
+		// Directory of the regions known at build time, created once and shared by default.
+		static const std::shared_ptr<const RegionDirectory>& known() {
+			static const std::shared_ptr<const RegionDirectory> directory = std::make_shared<const RegionDirectory>();
+			return directory;
+		}
+	};
+
+	// The batch calls are stateless and safe to call concurrently: out[i] receives the response for the i-th
+	// region, reusing the caller's string buffers.
 	class WeatherV1 {
 	public:
 		virtual void set_region(const char* region) = 0;
 		virtual std::string get_data() = 0;
+		virtual void get_data_batch(const char* const* regions, std::size_t count, std::string* out) const = 0;
 	};
 
 	class WeatherV2 {
 	public:
 		virtual void set_region(int region_id) = 0;
 		virtual std::string get_weather() = 0;
+		virtual void get_weather_batch(const int* region_ids, std::size_t count, std::string* out) const = 0;
 	};
 
+	// Adapters translate batches in chunks of this many regions, kept on the stack.
+	constexpr std::size_t k_region_batch_chunk = 256;
+
 
 	class RegionWeather : public WeatherV1 {
 	private:
 		std::string m_region;
-		std::map<const char*, std::string> m_region_data;
+		std::shared_ptr<const RegionDirectory> m_regions;
 	public:
-		RegionWeather() {
-			m_region_data["eu_east"] = "Weather is Good)";
-			m_region_data["eu_west"] = "Weather is Okey)";
-			m_region_data["us_east"] = "Weather is Fine)";
-			m_region_data["us_west"] = "Weather is Great)";
-		}
+		RegionWeather(std::shared_ptr<const RegionDirectory> regions = RegionDirectory::known())
+			: m_regions(regions) {}
 
 		void set_region(const char* region) { m_region = region; };
 		std::string get_data() {
-			if (m_region_data.find(m_region.c_str()) != m_region_data.end())
-				return "Weather API version 1: " + m_region_data[m_region.c_str()];
-			return "Weather API version 1: Region data missing";
+			std::string data;
+			write_data(m_region, data);
+			return data;
+		};
+		void get_data_batch(const char* const* regions, std::size_t count, std::string* out) const {
+			for (std::size_t i = 0; i < count; i++) write_data(regions[i], out[i]);
+		}
+	private:
+		void write_data(std::string_view region, std::string& out) const {
+			out.assign("Weather API version 1: ");
+			if (int id = m_regions->id_of(region)) out.append(m_regions->weather_of(id));
+			else out.append("Region data missing");
+		}
+	};
+
+	// Per-region response cache with a fixed time to live. Loads are single-flight: while one caller fetches a
+	// region, concurrent callers for the same region wait for that result instead of hitting the backend too.
+	// Expired entries are swept at most once per TTL, on a miss.
+	class WeatherCache {
+	private:
+		struct Entry {
+			std::optional<std::string> response;
+			std::chrono::steady_clock::time_point expires;
+			bool loading = false;
+			int waiters = 0; // callers blocked on the load, the entry can't be swept under them
 		};
+		std::chrono::steady_clock::duration m_ttl;
+		std::chrono::steady_clock::time_point m_next_sweep;
+		std::mutex m_mutex;
+		std::condition_variable m_loaded;
+		std::unordered_map<int, Entry> m_entries;
+		std::atomic<std::size_t> m_hits{ 0 }, m_misses{ 0 }, m_coalesced{ 0 };
+
+		// Called with m_mutex held.
+		void sweep(std::chrono::steady_clock::time_point now) {
+			if (now < m_next_sweep) return;
+			m_next_sweep = now + m_ttl;
+			for (auto it = m_entries.begin(); it != m_entries.end();) {
+				const Entry& entry = it->second;
+				if (!entry.loading && entry.waiters == 0 && entry.expires <= now) it = m_entries.erase(it);
+				else ++it;
+			}
+		}
+	public:
+		WeatherCache(std::chrono::steady_clock::duration ttl) : m_ttl(ttl) {}
+
+		std::string get(int region_id, const std::function<std::string()>& load) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			Entry& entry = m_entries[region_id];
+			if (entry.loading) {
+				m_coalesced++;
+				entry.waiters++;
+				m_loaded.wait(lock, [&]() { return !entry.loading; });
+				entry.waiters--;
+			}
+			if (entry.response && std::chrono::steady_clock::now() < entry.expires) {
+				m_hits++;
+				return *entry.response;
+			}
+
+			m_misses++;
+			entry.loading = true;
+			lock.unlock();
+			std::string response;
+			try {
+				response = load();
+			}
+			catch (...) {
+				lock.lock();
+				entry.loading = false;
+				m_loaded.notify_all();
+				throw;
+			}
+
+			lock.lock();
+			const auto now = std::chrono::steady_clock::now();
+			entry.response = response;
+			entry.expires = now + m_ttl;
+			entry.loading = false;
+			m_loaded.notify_all();
+			sweep(now);
+			return response;
+		}
+
+		std::size_t hits() const { return m_hits; }
+		std::size_t misses() const { return m_misses; }
+		std::size_t coalesced() const { return m_coalesced; }
+		std::size_t size() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_entries.size();
+		}
 	};
 
 	class RegionWeatherAdapter : public WeatherV2 {
 	private:
 		std::shared_ptr<WeatherV1> m_adaptee;
-		std::map<int, const char*> m_id_to_name_map;
+		std::shared_ptr<WeatherCache> m_cache;
+		std::shared_ptr<const RegionDirectory> m_regions;
+		int m_region_id = 0;
 	public:
-		RegionWeatherAdapter(std::shared_ptr<WeatherV1> adaptee) 
-			: m_adaptee(adaptee) {
-			m_id_to_name_map[1] = "eu_east";
-			m_id_to_name_map[2] = "eu_west";
-			m_id_to_name_map[3] = "us_east";
-			m_id_to_name_map[4] = "us_west";
-		}
-		void set_region(int region_id) { m_adaptee->set_region(m_id_to_name_map[region_id]); };
+		// Adapters that share a cache share its responses. A cached adapter never changes the adaptee's selected
+		// region and loads misses through the stateless batch call, so many adapters can share one adaptee.
+		RegionWeatherAdapter(std::shared_ptr<WeatherV1> adaptee, std::shared_ptr<WeatherCache> cache = nullptr,
+			std::shared_ptr<const RegionDirectory> regions = RegionDirectory::known())
+			: m_adaptee(adaptee), m_cache(cache), m_regions(regions) {}
+		void set_region(int region_id) {
+			m_region_id = region_id;
+			if (!m_cache) m_adaptee->set_region(m_regions->name_of(region_id));
+		};
 		std::string get_weather() {
-			return m_adaptee->get_data();
+			if (!m_cache) return m_adaptee->get_data();
+			const int region_id = m_region_id;
+			return m_cache->get(region_id, [&]() {
+				const char* name = m_regions->name_of(region_id);
+				std::string response;
+				m_adaptee->get_data_batch(&name, 1, &response);
+				return response;
+			});
 		};
+		void get_weather_batch(const int* region_ids, std::size_t count, std::string* out) const {
+			const char* names[k_region_batch_chunk];
+			if (m_cache) {
+				for (std::size_t i = 0; i < count; i++) {
+					names[0] = m_regions->name_of(region_ids[i]);
+					out[i] = m_cache->get(region_ids[i], [&]() {
+						std::string response;
+						m_adaptee->get_data_batch(names, 1, &response);
+						return response;
+					});
+				}
+				return;
+			}
+			for (std::size_t first = 0; first < count; first += k_region_batch_chunk) {
+				std::size_t chunk = std::min(count - first, k_region_batch_chunk);
+				for (std::size_t i = 0; i < chunk; i++) names[i] = m_regions->name_of(region_ids[first + i]);
+				m_adaptee->get_data_batch(names, chunk, out + first);
+			}
+		}
 
+		const std::shared_ptr<WeatherV1>& adaptee() const { return m_adaptee; }
+		const std::shared_ptr<const RegionDirectory>& regions() const { return m_regions; }
+		bool cached() const { return m_cache != nullptr; }
 	};
 
 	class RegionWeatherAdapterAdapter : public WeatherV1 {
 	private:
 		std::shared_ptr<WeatherV2> m_adaptee;
-		std::map<std::string, int> m_name_to_id_map;
+		std::shared_ptr<const RegionDirectory> m_regions;
 	public:
-		RegionWeatherAdapterAdapter(std::shared_ptr<WeatherV2> adaptee) 
-			: m_adaptee(adaptee) {
-			m_name_to_id_map["eu_east"] = 1;
-			m_name_to_id_map["eu_west"] = 2;
-			m_name_to_id_map["us_east"] = 3;
-			m_name_to_id_map["us_west"] = 4;
-		}
-		void set_region(const char* region) { m_adaptee->set_region(m_name_to_id_map[region]); };
+		RegionWeatherAdapterAdapter(std::shared_ptr<WeatherV2> adaptee, std::shared_ptr<const RegionDirectory> regions = RegionDirectory::known()) 
+			: m_adaptee(adaptee), m_regions(regions) {}
+		void set_region(const char* region) { m_adaptee->set_region(m_regions->id_of(region)); };
 		std::string get_data() {
 			return m_adaptee->get_weather();
 		};
+		void get_data_batch(const char* const* regions, std::size_t count, std::string* out) const {
+			int ids[k_region_batch_chunk];
+			for (std::size_t first = 0; first < count; first += k_region_batch_chunk) {
+				std::size_t chunk = std::min(count - first, k_region_batch_chunk);
+				for (std::size_t i = 0; i < chunk; i++) ids[i] = m_regions->id_of(regions[first + i]);
+				m_adaptee->get_weather_batch(ids, chunk, out + first);
+			}
+		}
+
+		const std::shared_ptr<WeatherV2>& adaptee() const { return m_adaptee; }
+		const std::shared_ptr<const RegionDirectory>& regions() const { return m_regions; }
 	};
+
+	// Adapter factories. Wrapping an adapter in its inverse translates name -> id -> name (or back) for nothing,
+	// so when both sides use the same directory the original adaptee is returned instead. A cached adapter
+	// is kept, the cache changes what callers observe.
+	std::shared_ptr<WeatherV2> adapt_v2(std::shared_ptr<WeatherV1> weather, std::shared_ptr<WeatherCache> cache = nullptr,
+		std::shared_ptr<const RegionDirectory> regions = RegionDirectory::known()) {
+		auto inverse = std::dynamic_pointer_cast<RegionWeatherAdapterAdapter>(weather);
+		if (inverse && !cache && inverse->regions() == regions) return inverse->adaptee();
+		return std::make_shared<RegionWeatherAdapter>(weather, cache, regions);
+	}
+
+	std::shared_ptr<WeatherV1> adapt_v1(std::shared_ptr<WeatherV2> weather,
+		std::shared_ptr<const RegionDirectory> regions = RegionDirectory::known()) {
+		auto inverse = std::dynamic_pointer_cast<RegionWeatherAdapter>(weather);
+		if (inverse && !inverse->cached() && inverse->regions() == regions) return inverse->adaptee();
+		return std::make_shared<RegionWeatherAdapterAdapter>(weather, regions);
+	}
 }
 
 
@@ -105,5 +369,244 @@ int AdapterPattern::run() {
 		weather->set_region("eu_east");
 		std::cout << "\n" << "Old client logic new interface result: " << weather->get_data() << std::endl;
 	}
+
+	// Regions added at runtime go to the fallback table, names are matched by content.
+	// The extended directory is built once and shared, read-only, by the whole adapter stack.
+	{
+		auto directory = std::make_shared<RegionDirectory>();
+		directory->add_region("ap_south", "Weather is Hot)");
+		std::shared_ptr<const RegionDirectory> regions = directory;
+
+		std::shared_ptr<WeatherV1> weather = std::make_shared<RegionWeatherAdapterAdapter>(
+			std::make_shared<RegionWeatherAdapter>(std::make_shared<RegionWeather>(regions), nullptr, regions), regions);
+		std::string region = "ap_south";
+		weather->set_region(region.c_str());
+		std::cout << "\n" << "Runtime region result: " << weather->get_data() << std::endl;
+	}
+
+	// Adapter stack construction: per-instance std::map tables as before against the shared directory
+	{
+		const std::size_t constructions = 200000;
+		double legacy_ns = benchmark::ns_per_op(constructions, [](std::size_t) {
+			std::map<const char*, std::string> region_data;
+			std::map<int, const char*> id_to_name;
+			std::map<std::string, int> name_to_id;
+			for (auto& region : k_known_regions) {
+				region_data[region.name.data()] = std::string(region.weather);
+				id_to_name[region.id] = region.name.data();
+				name_to_id[std::string(region.name)] = region.id;
+			}
+			std::shared_ptr<WeatherV1> weather = std::make_shared<RegionWeatherAdapterAdapter>(std::make_shared<RegionWeatherAdapter>(std::make_shared<RegionWeather>()));
+			benchmark::keep(region_data.size() + id_to_name.size() + name_to_id.size());
+		});
+		double shared_ns = benchmark::ns_per_op(constructions, [](std::size_t) {
+			std::shared_ptr<WeatherV1> weather = std::make_shared<RegionWeatherAdapterAdapter>(std::make_shared<RegionWeatherAdapter>(std::make_shared<RegionWeather>()));
+			benchmark::keep((std::size_t)weather.get());
+		});
+		std::cout << "\n" << "Adapter stacks/sec: per-instance tables " << 1e9 / legacy_ns << ", shared directory " << 1e9 / shared_ns << std::endl;
+	}
+
+	// Per-call cost of adapter stacks built directly against the collapsing factories
+	{
+		auto backend = std::make_shared<RegionWeather>();
+		std::shared_ptr<WeatherV2> direct1 = std::make_shared<RegionWeatherAdapter>(backend);
+		std::shared_ptr<WeatherV1> direct2 = std::make_shared<RegionWeatherAdapterAdapter>(direct1);
+		std::shared_ptr<WeatherV1> direct4 = std::make_shared<RegionWeatherAdapterAdapter>(std::make_shared<RegionWeatherAdapter>(direct2));
+
+		std::shared_ptr<WeatherV2> collapsed1 = adapt_v2(backend);
+		std::shared_ptr<WeatherV1> collapsed2 = adapt_v1(collapsed1);
+		std::shared_ptr<WeatherV1> collapsed4 = adapt_v1(adapt_v2(collapsed2));
+		std::cout << "\n" << "Collapsed stacks: 2-deep is backend " << (collapsed2 == backend) << ", 4-deep is backend " << (collapsed4 == backend) << std::endl;
+		if (collapsed2 != backend || collapsed4 != backend) return 1;
+
+		const char* names[] = { "eu_east", "eu_west", "us_east", "unknown" };
+		for (const char* name : names) {
+			direct4->set_region(name);
+			collapsed4->set_region(name);
+			if (direct4->get_data() != collapsed4->get_data()) return 1;
+		}
+
+		const std::size_t calls = 200000;
+		auto v1_calls = [&](const std::shared_ptr<WeatherV1>& weather) {
+			return benchmark::ns_per_op(calls, [&](std::size_t i) {
+				weather->set_region(names[i & 3]);
+				benchmark::keep(weather->get_data().size());
+			});
+		};
+		auto v2_calls = [&](const std::shared_ptr<WeatherV2>& weather) {
+			return benchmark::ns_per_op(calls, [&](std::size_t i) {
+				weather->set_region((int)(i & 3) + 1);
+				benchmark::keep(weather->get_weather().size());
+			});
+		};
+		std::cout << "ns per call, direct / collapsed: 1-deep " << v2_calls(direct1) << " / " << v2_calls(collapsed1)
+			<< ", 2-deep " << v1_calls(direct2) << " / " << v1_calls(collapsed2)
+			<< ", 4-deep " << v1_calls(direct4) << " / " << v1_calls(collapsed4) << std::endl;
+	}
+
+	// Batch queries: one stateless call per batch against set_region + get_weather per region
+	{
+		std::shared_ptr<WeatherV2> weather = std::make_shared<RegionWeatherAdapter>(std::make_shared<RegionWeather>());
+
+		// Four threads share one adapter and check every response
+		const std::size_t batch = 1000;
+		std::vector<int> ids(batch);
+		for (std::size_t i = 0; i < batch; i++) ids[i] = (int)(i % 5); // id 0 is unknown
+		std::atomic<int> mismatches{ 0 };
+		std::vector<std::thread> clients;
+		for (int t = 0; t < 4; t++) {
+			clients.emplace_back([&]() {
+				std::vector<std::string> out(batch);
+				for (int round = 0; round < 20; round++) {
+					weather->get_weather_batch(ids.data(), batch, out.data());
+					for (std::size_t i = 0; i < batch; i++) {
+						std::string_view expected = ids[i] ? k_known_regions[ids[i] - 1].weather : std::string_view("Region data missing");
+						if (out[i].size() < expected.size() || out[i].compare(out[i].size() - expected.size(), expected.size(), expected) != 0) mismatches++;
+					}
+				}
+			});
+		}
+		for (auto& client : clients) client.join();
+		std::cout << "\n" << "Concurrent batches: 4 threads, " << mismatches << " mismatched response(s)" << std::endl;
+		if (mismatches) return 1;
+
+		std::cout << "Regions/sec, per-region calls / batch:";
+		for (std::size_t size : { (std::size_t)1, (std::size_t)100, (std::size_t)10000 }) {
+			std::vector<int> batch_ids(size);
+			for (std::size_t i = 0; i < size; i++) batch_ids[i] = (int)(i & 3) + 1;
+			std::vector<std::string> out(size);
+			const std::size_t rounds = 200000 / size;
+
+			double single_ns = benchmark::ns_per_op(rounds, [&](std::size_t) {
+				for (std::size_t i = 0; i < size; i++) {
+					weather->set_region(batch_ids[i]);
+					out[i] = weather->get_weather();
+				}
+				benchmark::keep(out[size - 1].size());
+			});
+			double batch_ns = benchmark::ns_per_op(rounds, [&](std::size_t) {
+				weather->get_weather_batch(batch_ids.data(), size, out.data());
+				benchmark::keep(out[size - 1].size());
+			});
+			std::cout << " " << size << ": " << 1e9 * size / single_ns << " / " << 1e9 * size / batch_ns << (size == 10000 ? "" : ",");
+		}
+		std::cout << std::endl;
+	}
+
+	// Cached adapter over a deliberately slow backend
+	{
+		class SlowRegionWeather : public RegionWeather {
+		public:
+			mutable std::atomic<int> m_calls{ 0 };
+			std::string get_data() override {
+				m_calls++;
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				return RegionWeather::get_data();
+			}
+			void get_data_batch(const char* const* regions, std::size_t count, std::string* out) const override {
+				m_calls++;
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				RegionWeather::get_data_batch(regions, count, out);
+			}
+		};
+
+		// Eight concurrent misses for one region cost one backend call
+		auto backend = std::make_shared<SlowRegionWeather>();
+		auto cache = std::make_shared<WeatherCache>(std::chrono::seconds(60));
+		std::vector<std::thread> clients;
+		for (int i = 0; i < 8; i++) {
+			clients.emplace_back([&]() {
+				RegionWeatherAdapter weather(backend, cache);
+				weather.set_region(1);
+				weather.get_weather();
+			});
+		}
+		for (auto& client : clients) client.join();
+		std::cout << "\n" << "Concurrent misses: 8 clients, " << backend->m_calls << " backend call(s), " << cache->coalesced() << " coalesced" << std::endl;
+		if (backend->m_calls != 1) return 1;
+
+		// Clients for different regions share one backend, each response must be cached under its own region
+		auto mixed_backend = std::make_shared<SlowRegionWeather>();
+		auto mixed_cache = std::make_shared<WeatherCache>(std::chrono::seconds(60));
+		std::atomic<bool> mixed_up(false);
+		clients.clear();
+		for (int i = 0; i < 8; i++) {
+			clients.emplace_back([&, i]() {
+				RegionWeatherAdapter weather(mixed_backend, mixed_cache);
+				for (int round = 0; round < 4; round++) {
+					int region_id = (i + round) % 4 + 1;
+					weather.set_region(region_id);
+					std::string expected;
+					const char* name = RegionDirectory::known()->name_of(region_id);
+					RegionWeather().get_data_batch(&name, 1, &expected);
+					if (weather.get_weather() != expected) mixed_up = true;
+				}
+			});
+		}
+		for (auto& client : clients) client.join();
+		std::cout << "Concurrent regions: 8 clients over 4 regions, " << mixed_backend->m_calls << " backend call(s), "
+			<< (mixed_up ? "MIXED UP" : "all responses match their region") << std::endl;
+		if (mixed_up || mixed_backend->m_calls != 4) return 1;
+
+		const int requests = 100;
+		auto uncached_backend = std::make_shared<SlowRegionWeather>();
+		RegionWeatherAdapter uncached(uncached_backend);
+		double uncached_ms = benchmark::elapsed_ms([&]() {
+			for (int i = 0; i < requests; i++) {
+				uncached.set_region(i % 4 + 1);
+				uncached.get_weather();
+			}
+		});
+
+		auto cached_backend = std::make_shared<SlowRegionWeather>();
+		auto ttl_cache = std::make_shared<WeatherCache>(std::chrono::milliseconds(50));
+		RegionWeatherAdapter cached(cached_backend, ttl_cache);
+		double cached_ms = benchmark::elapsed_ms([&]() {
+			for (int i = 0; i < requests; i++) {
+				cached.set_region(i % 4 + 1);
+				cached.get_weather();
+			}
+		});
+		std::cout << "Slow backend(" << requests << " requests): uncached " << uncached_ms << " ms, cached " << cached_ms
+			<< " ms(hits " << ttl_cache->hits() << ", misses " << ttl_cache->misses() << ")" << std::endl;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(60));
+		cached.get_weather();
+		std::cout << "After the TTL expired: misses " << ttl_cache->misses() << ", cached regions " << ttl_cache->size() << std::endl;
+		if (ttl_cache->size() != 1) return 1;
+
+		// An empty response is a real response and is cached like any other
+		WeatherCache empty_cache(std::chrono::seconds(60));
+		int empty_loads = 0;
+		for (int i = 0; i < 3; i++) empty_cache.get(1, [&]() { empty_loads++; return std::string(); });
+		if (empty_loads != 1) return 1;
+	}
+
+	// Region lookup throughput: the previous std::map tables against the perfect hash directory
+	{
+		std::map<const char*, std::string> pointer_data;
+		std::map<std::string, int> name_to_id;
+		std::map<int, const char*> id_to_name;
+		std::vector<std::string> names;
+		for (auto& region : k_known_regions) {
+			pointer_data[region.name.data()] = std::string(region.weather);
+			name_to_id[std::string(region.name)] = region.id;
+			id_to_name[region.id] = region.name.data();
+			names.push_back(std::string(region.name));
+		}
+		const RegionDirectory& directory = *RegionDirectory::known();
+
+		const std::size_t lookups = 2000000;
+		double map_name_ns = benchmark::ns_per_op(lookups, [&](std::size_t i) { benchmark::keep(name_to_id.find(names[i & 3])->second); });
+		double map_id_ns = benchmark::ns_per_op(lookups, [&](std::size_t i) { benchmark::keep((std::size_t)id_to_name.find((int)(i & 3) + 1)->second); });
+		double map_data_ns = benchmark::ns_per_op(lookups, [&](std::size_t i) { benchmark::keep(pointer_data.find(k_known_regions[i & 3].name.data())->second.size()); });
+		double hash_name_ns = benchmark::ns_per_op(lookups, [&](std::size_t i) { benchmark::keep(directory.id_of(names[i & 3])); });
+		double hash_id_ns = benchmark::ns_per_op(lookups, [&](std::size_t i) { benchmark::keep((std::size_t)directory.name_of((int)(i & 3) + 1)); });
+		double hash_data_ns = benchmark::ns_per_op(lookups, [&](std::size_t i) { benchmark::keep(directory.weather_of(directory.id_of(names[i & 3])).size()); });
+
+		std::cout << "\n" << "Region lookups(ns): name->id map " << map_name_ns << " / perfect hash " << hash_name_ns
+			<< ", id->name map " << map_id_ns << " / table " << hash_id_ns
+			<< ", name->data pointer map " << map_data_ns << " / perfect hash " << hash_data_ns << std::endl;
+	}
 	return 0;
 }
\ No newline at end of file
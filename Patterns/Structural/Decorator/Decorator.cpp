@@ -1,5 +1,11 @@
 #include "Decorator.h"
+#include "../../Benchmark.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 
@@ -10,61 +16,282 @@ namespace decorator_pattern {
 		std::shared_ptr<Telescope> m_telescope;
 	public:
 		virtual float magnification() = 0;
+
+		// Walks the whole decorator stack instead of using cached values.
+		virtual float uncached_magnification() { return magnification(); }
+
+		// Wrapped telescope, empty for a bare telescope.
+		std::shared_ptr<Telescope> inner() const { return m_telescope; }
 	};
 
 
 	class OmegonTelescope : public Telescope {
 	public:
+		static constexpr float k_magnification = 2.0f;
 		float magnification() {
-			return 2.0f;
+			return k_magnification;
 		};
 	};
 
 	class PrimeTelescope : public Telescope {
 	public:
+		static constexpr float k_magnification = 10.0f;
 		float magnification() {
-			return 10.0f;
+			return k_magnification;
 		};
 	};
 
 	class DeltaTelescope : public Telescope {
 	public:
+		static constexpr float k_magnification = 100.0f;
 		float magnification() {
-			return 100.0f;
+			return k_magnification;
 		};
 	};
 
 
-	class Lense2x : public Telescope {
-	public:
-		Lense2x(std::shared_ptr<Telescope> telescope) {
+	// Decorators never change after construction, so each lens multiplies its inner value once and caches it.
+	// A query is O(1) however deep the stack is; rebuilding the stack creates new lenses with fresh values.
+	class Lense : public Telescope {
+	private:
+		float m_factor;
+		float m_magnification;
+	protected:
+		Lense(std::shared_ptr<Telescope> telescope, float factor)
+			: m_factor(factor), m_magnification(telescope->magnification() * factor) {
 			m_telescope = telescope;
 		}
-		float magnification() {
-			return m_telescope->magnification() * 2.0f;
+	public:
+		float factor() const { return m_factor; }
+		float magnification() override {
+			return m_magnification;
+		};
+		float uncached_magnification() override {
+			return m_telescope->uncached_magnification() * m_factor;
 		};
 	};
 
-	class Lense5x : public Telescope {
+	class Lense2x : public Lense {
+	public:
+		static constexpr float k_factor = 2.0f;
+		Lense2x(std::shared_ptr<Telescope> telescope) : Lense(telescope, k_factor) {}
+	};
 
+	class Lense5x : public Lense {
 	public:
-		Lense5x(std::shared_ptr<Telescope> telescope) {
-			m_telescope = telescope;
+		static constexpr float k_factor = 5.0f;
+		Lense5x(std::shared_ptr<Telescope> telescope) : Lense(telescope, k_factor) {}
+	};
+
+	class Lense0_5x : public Lense {
+	public:
+		static constexpr float k_factor = 0.5f;
+		Lense0_5x(std::shared_ptr<Telescope> telescope) : Lense(telescope, k_factor) {}
+	};
+
+	// Lens with a factor chosen at runtime, for catalogs loaded from data.
+	class CustomLense : public Lense {
+	public:
+		CustomLense(std::shared_ptr<Telescope> telescope, float factor) : Lense(telescope, factor) {}
+	};
+
+
+	// Flat snapshot of many decorator chains for bulk evaluation: each telescope becomes a base value plus one
+	// multiplier per level, stored column by column and padded with 1.0, so evaluation is one vectorizable
+	// multiply loop per level instead of a pointer chase per telescope. Results match the decorators exactly
+	// because the multiplications happen in the same order.
+	class MagnificationBatch {
+	private:
+		static constexpr std::size_t k_block = 8; // columns are padded to whole blocks so the inner loop has a fixed width
+		std::size_t m_count = 0;
+		std::size_t m_stride = 0;
+		std::size_t m_depth = 0;
+		std::vector<float> m_base;
+		std::vector<float> m_factors; // level-major: m_factors[level * m_stride + telescope]
+	public:
+		MagnificationBatch(const std::vector<std::shared_ptr<Telescope>>& telescopes)
+			: m_count(telescopes.size()), m_stride((telescopes.size() + k_block - 1) / k_block * k_block), m_base(m_stride, 1.0f) {
+			std::vector<std::vector<float>> chains(m_count);
+			for (std::size_t i = 0; i < m_count; i++) {
+				std::shared_ptr<Telescope> telescope = telescopes[i];
+				while (auto lense = std::dynamic_pointer_cast<Lense>(telescope)) {
+					chains[i].push_back(lense->factor());
+					telescope = lense->inner();
+				}
+				m_base[i] = telescope->magnification();
+				m_depth = std::max(m_depth, chains[i].size());
+			}
+
+			m_factors.assign(m_depth * m_stride, 1.0f);
+			for (std::size_t i = 0; i < m_count; i++) {
+				// chains hold outermost first; level 0 is the lens closest to the telescope
+				const std::size_t levels = chains[i].size();
+				for (std::size_t level = 0; level < levels; level++) m_factors[level * m_stride + i] = chains[i][levels - 1 - level];
+			}
+		}
+
+		void evaluate(std::vector<float>& out) const {
+			out.assign(m_base.begin(), m_base.end());
+			float* result = out.data();
+			for (std::size_t level = 0; level < m_depth; level++) {
+				const float* factors = m_factors.data() + level * m_stride;
+				for (std::size_t i = 0; i < m_stride; i += k_block) {
+					// All loads before all stores, so the block vectorizes even though result and factors could alias.
+					float block[k_block];
+					for (std::size_t k = 0; k < k_block; k++) block[k] = result[i + k] * factors[i + k];
+					for (std::size_t k = 0; k < k_block; k++) result[i + k] = block[k];
+				}
+			}
+			out.resize(m_count);
 		}
-		float magnification() {
-			return m_telescope->magnification() * 5.0f;
-		};
 	};
 
-	class Lense0_5x : public Telescope {
+
+	struct LenseType {
+		std::string name;
+		float factor;
+		float cost;
+		std::function<std::shared_ptr<Telescope>(std::shared_ptr<Telescope>)> wrap;
+	};
+
+	// Finds a cheap stack of catalog lenses that brings a telescope within a relative tolerance of a target
+	// magnification. Stacking multiplies, so the search is a shortest-path DP over log-magnification: one layer per
+	// stack depth, states bucketed into bins in log space, each bin keeping its cheapest stack.
+	// Binning makes the search approximate. Bins are slack / (2 * max_depth) wide in log space, so the kept states
+	// drift at most half the log tolerance from any stack they replaced. The result is always within tolerance, and
+	// no stack within half the tolerance is cheaper. Each layer only spans the range that can still reach the target.
+	// A query whose tolerance is too small for the catalog and depth to fit in k_max_bins is rejected.
+	class LenseSearch {
 	public:
-		Lense0_5x(std::shared_ptr<Telescope> telescope) {
-			m_telescope = telescope;
+		static constexpr std::size_t k_max_bins = std::size_t(1) << 22;
+	private:
+		struct Link {
+			int parent_bin = -1;
+			int lense = -1;
+		};
+		struct Layer {
+			double low = 0;
+			double high = -1;
+			std::size_t bins = 0;
+			std::vector<Link> links;
+			// Only held while the layer is being expanded
+			std::vector<float> cost;
+			std::vector<double> log_magnification;
+		};
+		std::vector<LenseType> m_catalog;
+		std::vector<double> m_log_factors;
+	public:
+		LenseSearch(std::vector<LenseType> catalog) : m_catalog(std::move(catalog)) {
+			for (const auto& lense : m_catalog) {
+				if (!(lense.factor > 0) || !std::isfinite(lense.factor)) throw std::invalid_argument("Lense factor must be positive and finite: " + lense.name);
+				if (!(lense.cost >= 0)) throw std::invalid_argument("Lense cost must not be negative: " + lense.name);
+				m_log_factors.push_back(std::log((double)lense.factor));
+			}
 		}
-		float magnification() {
-			return m_telescope->magnification() * 0.5f;
+
+		// Returns the built decorator chain, or nullptr when no stack of at most max_depth lenses lands in tolerance.
+		std::shared_ptr<Telescope> find(std::shared_ptr<Telescope> telescope, float target, float tolerance, int max_depth,
+			std::vector<int>* picked = nullptr) const {
+			if (!(tolerance > 0) || max_depth < 0) throw std::invalid_argument("Lense search needs a positive tolerance and a non-negative depth");
+			const double base = telescope->magnification();
+			if (target <= 0 || base <= 0 || m_catalog.empty()) return nullptr;
+			const double need = std::log((double)target / base);
+			const double slack = std::log(1.0 + tolerance);
+			const double bin_width = slack / (2.0 * std::max(max_depth, 1));
+
+			double min_step = 0, max_step = 0;
+			for (double step : m_log_factors) {
+				min_step = std::min(min_step, step);
+				max_step = std::max(max_step, step);
+			}
+
+			std::vector<Layer> layers(max_depth + 1);
+			double total_bins = 0;
+			for (int depth = 0; depth <= max_depth; depth++) {
+				const int remaining = max_depth - depth;
+				Layer& layer = layers[depth];
+				layer.low = std::max(depth * min_step, need - slack - remaining * max_step);
+				layer.high = std::min(depth * max_step, need + slack - remaining * min_step);
+				if (layer.high < layer.low) continue;
+				const double bins = std::ceil((layer.high - layer.low) / bin_width) + 1;
+				total_bins += bins;
+				if (total_bins > (double)k_max_bins) throw std::invalid_argument("Lense search tolerance is too small for this catalog and depth");
+				layer.bins = (std::size_t)bins;
+			}
+			auto bin_of = [&](const Layer& layer, double log_magnification) -> long {
+				if (log_magnification < layer.low || log_magnification > layer.high) return -1;
+				return std::lround((log_magnification - layer.low) / bin_width);
+			};
+			auto open = [](Layer& layer) {
+				layer.links.resize(layer.bins);
+				layer.cost.assign(layer.bins, std::numeric_limits<float>::infinity());
+				layer.log_magnification.resize(layer.bins);
+			};
+
+			const long start = bin_of(layers[0], 0.0);
+			if (start < 0) return nullptr;
+			open(layers[0]);
+			layers[0].cost[start] = 0.0f;
+			layers[0].log_magnification[start] = 0.0;
+
+			int best_depth = -1, best_bin = -1;
+			float best_cost = std::numeric_limits<float>::infinity();
+			for (int depth = 0; depth <= max_depth; depth++) {
+				Layer& layer = layers[depth];
+				if (depth < max_depth) open(layers[depth + 1]);
+				for (int bin = 0; bin < (int)layer.bins; bin++) {
+					const float cost = layer.cost[bin];
+					if (cost >= best_cost) continue;
+					const double log_magnification = layer.log_magnification[bin];
+					if (std::fabs(log_magnification - need) <= slack) {
+						best_cost = cost;
+						best_depth = depth;
+						best_bin = bin;
+					}
+					if (depth == max_depth) continue;
+					Layer& next = layers[depth + 1];
+					for (int i = 0; i < (int)m_catalog.size(); i++) {
+						const double next_log = log_magnification + m_log_factors[i];
+						const long next_bin = bin_of(next, next_log);
+						if (next_bin < 0) continue;
+						const float next_cost = cost + m_catalog[i].cost;
+						if (next_cost >= next.cost[next_bin]) continue;
+						next.cost[next_bin] = next_cost;
+						next.log_magnification[next_bin] = next_log;
+						next.links[next_bin] = { bin, i };
+					}
+				}
+				std::vector<float>().swap(layer.cost);
+				std::vector<double>().swap(layer.log_magnification);
+			}
+			if (best_depth < 0) return nullptr;
+
+			std::vector<int> sequence;
+			for (int depth = best_depth, bin = best_bin; depth > 0; depth--) {
+				sequence.push_back(layers[depth].links[bin].lense);
+				bin = layers[depth].links[bin].parent_bin;
+			}
+			for (auto it = sequence.rbegin(); it != sequence.rend(); ++it) telescope = m_catalog[*it].wrap(telescope);
+			if (picked) picked->assign(sequence.rbegin(), sequence.rend());
+			return telescope;
+		}
+	};
+
+
+	// Decorator stack fixed at compile time. The magnification folds to a constant in the same order the dynamic
+	// stack multiplies it, and the type is still a Telescope, so it can be wrapped by dynamic lenses too.
+	template<typename BaseTelescope, typename... Lenses>
+	class Decorated : public Telescope {
+	public:
+		static constexpr float k_magnification = (BaseTelescope::k_magnification * ... * Lenses::k_factor);
+		float magnification() override {
+			return k_magnification;
 		};
 	};
+
+	using DeltaTripleFive = Decorated<DeltaTelescope, Lense5x, Lense5x, Lense5x>;
+	static_assert(DeltaTripleFive::k_magnification == 12500.0f, "Delta telescope with three 5x lenses must fold to 12500 at compile time");
+	static_assert(Decorated<OmegonTelescope, Lense2x, Lense0_5x, Lense5x>::k_magnification == 10.0f, "Omegon telescope stack must fold to 10");
 }
 
 
@@ -96,5 +323,144 @@ int DecoratorPattern::run() {
 	omegon_telescope = std::make_shared<Lense5x>(omegon_telescope);
 	std::cout << "Omegon Telescope Magnification(with lenses): " << omegon_telescope->magnification() << std::endl;
 
+	// The Delta configuration known at build time: same value, no decorator objects
+	std::shared_ptr<Telescope> static_delta = std::make_shared<DeltaTripleFive>();
+	std::cout << "\n" << "Compile-time Delta Telescope Magnification(with lenses): " << static_delta->magnification() << std::endl;
+	std::shared_ptr<Telescope> static_delta_2x = std::make_shared<Lense2x>(static_delta);
+	std::cout << "Compile-time Delta Telescope with a runtime 2x lens: " << static_delta_2x->magnification() << std::endl;
+	if (static_delta->magnification() != delta_telescope->magnification()) return 1;
+	{
+		const std::size_t queries = 2000000;
+		double dynamic_ns = benchmark::ns_per_op(queries, [&](std::size_t) { benchmark::keep((std::size_t)delta_telescope->uncached_magnification()); });
+		double virtual_ns = benchmark::ns_per_op(queries, [&](std::size_t) { benchmark::keep((std::size_t)static_delta->magnification()); });
+		double constant_ns = benchmark::ns_per_op(queries, [&](std::size_t) { benchmark::keep((std::size_t)DeltaTripleFive::k_magnification); });
+		std::cout << "Delta query: dynamic stack walk " << dynamic_ns << " ns, compile-time stack via Telescope " << virtual_ns << " ns, folded constant " << constant_ns << " ns" << std::endl;
+	}
+
+	// Cheapest lens stack for a target magnification
+	{
+		std::vector<LenseType> catalog = {
+			{ "2x", Lense2x::k_factor, 1.0f, [](std::shared_ptr<Telescope> t) { return std::make_shared<Lense2x>(t); } },
+			{ "5x", Lense5x::k_factor, 3.0f, [](std::shared_ptr<Telescope> t) { return std::make_shared<Lense5x>(t); } },
+			{ "0.5x", Lense0_5x::k_factor, 1.0f, [](std::shared_ptr<Telescope> t) { return std::make_shared<Lense0_5x>(t); } }
+		};
+		LenseSearch search(catalog);
+		std::vector<int> picked;
+		std::shared_ptr<Telescope> found = search.find(std::make_shared<PrimeTelescope>(), 400.0f, 0.01f, 12, &picked);
+		if (!found) return 1;
+
+		float cost = 0;
+		std::cout << "\n" << "Cheapest Prime Telescope stack for 400x:";
+		for (int i : picked) {
+			std::cout << " " << catalog[i].name;
+			cost += catalog[i].cost;
+		}
+		std::cout << " -> " << found->magnification() << "x, cost " << cost << std::endl;
+
+		// Brute force over every sequence of up to 12 lenses must not find anything cheaper within half the tolerance
+		const double need = std::log(400.0 / PrimeTelescope::k_magnification), half_slack = std::log(1.01) / 2;
+		float brute_cost = std::numeric_limits<float>::infinity();
+		std::function<void(double, float, int)> brute = [&](double log_magnification, float spent, int depth) {
+			if (spent >= brute_cost) return;
+			if (std::fabs(log_magnification - need) <= half_slack) brute_cost = spent;
+			if (depth == 12) return;
+			for (auto& lense : catalog) brute(log_magnification + std::log((double)lense.factor), spent + lense.cost, depth + 1);
+		};
+		brute(0.0, 0.0f, 0);
+		if (brute_cost < cost || std::fabs(found->magnification() / 400.0f - 1.0f) > 0.01f) return 1;
+
+		bool rejected = false;
+		try {
+			LenseSearch broken({ { "0x", 0.0f, 1.0f, nullptr } });
+		}
+		catch (const std::invalid_argument&) {
+			rejected = true;
+		}
+		if (!rejected) return 1;
+
+		rejected = false;
+		try {
+			search.find(std::make_shared<PrimeTelescope>(), 400.0f, 1e-9f, 12);
+		}
+		catch (const std::invalid_argument& error) {
+			std::cout << "Tolerance 1e-9 rejected: " << error.what() << std::endl;
+			rejected = true;
+		}
+		if (!rejected) return 1;
+
+		for (int catalog_size : { 10, 25, 50 }) {
+			std::vector<LenseType> generated;
+			unsigned int seed = 7;
+			for (int i = 0; i < catalog_size; i++) {
+				seed = seed * 1664525u + 1013904223u;
+				float factor = 0.5f + (seed >> 8) % 9500 / 1000.0f;
+				seed = seed * 1664525u + 1013904223u;
+				float lense_cost = 1.0f + (seed >> 8) % 100 / 10.0f;
+				generated.push_back({ std::to_string(factor) + "x", factor, lense_cost,
+					[factor](std::shared_ptr<Telescope> t) { return std::make_shared<CustomLense>(t, factor); } });
+			}
+			LenseSearch generated_search(generated);
+			std::shared_ptr<Telescope> result;
+			double ms = benchmark::elapsed_ms([&]() { result = generated_search.find(std::make_shared<PrimeTelescope>(), 123456.0f, 0.001f, 12); });
+			std::cout << "  catalog " << catalog_size << ", depth 12: " << ms << " ms -> " << (result ? result->magnification() : 0.0f) << "x" << std::endl;
+		}
+	}
+
+	// Bulk evaluation of many telescope configurations
+	{
+		const std::size_t configurations = 10000;
+		std::vector<std::shared_ptr<Telescope>> telescopes;
+		unsigned int seed = 11;
+		for (std::size_t i = 0; i < configurations; i++) {
+			std::shared_ptr<Telescope> telescope;
+			if (i % 3 == 0) telescope = std::make_shared<OmegonTelescope>();
+			else if (i % 3 == 1) telescope = std::make_shared<PrimeTelescope>();
+			else telescope = std::make_shared<DeltaTelescope>();
+			seed = seed * 1664525u + 1013904223u;
+			for (unsigned int level = 0; level < (seed >> 16) % 13; level++) {
+				switch ((seed >> level) % 3) {
+				case 0: telescope = std::make_shared<Lense2x>(telescope); break;
+				case 1: telescope = std::make_shared<Lense5x>(telescope); break;
+				default: telescope = std::make_shared<Lense0_5x>(telescope); break;
+				}
+			}
+			telescopes.push_back(telescope);
+		}
+
+		MagnificationBatch batch(telescopes);
+		std::vector<float> walked(configurations), cached(configurations), batched;
+		const int rounds = 20;
+		double walk_ms = benchmark::elapsed_ms([&]() {
+			for (int round = 0; round < rounds; round++)
+				for (std::size_t i = 0; i < configurations; i++) walked[i] = telescopes[i]->uncached_magnification();
+		});
+		double cached_ms = benchmark::elapsed_ms([&]() {
+			for (int round = 0; round < rounds; round++)
+				for (std::size_t i = 0; i < configurations; i++) cached[i] = telescopes[i]->magnification();
+		});
+		double batch_ms = benchmark::elapsed_ms([&]() { for (int round = 0; round < rounds; round++) batch.evaluate(batched); });
+		if (batched != walked || cached != walked) return 1;
+
+		auto per_second = [&](double ms) { return configurations * rounds / (ms / 1000.0); };
+		std::cout << "\n" << "Configurations/sec(" << configurations << " telescopes): virtual walk " << per_second(walk_ms)
+			<< ", cached virtual " << per_second(cached_ms) << ", batch " << per_second(batch_ms) << std::endl;
+	}
+
+	// Query cost for deep stacks: walking every decorator against the cached value
+	std::cout << "\n" << "Magnification query cost:" << std::endl;
+	for (int depth : { 1, 10, 100, 1000 }) {
+		std::shared_ptr<Telescope> telescope = std::make_shared<PrimeTelescope>();
+		for (int i = 0; i < depth; i++) {
+			if (i % 2 == 0) telescope = std::make_shared<Lense2x>(telescope);
+			else telescope = std::make_shared<Lense0_5x>(telescope);
+		}
+		if (telescope->magnification() != telescope->uncached_magnification()) return 1;
+
+		const std::size_t queries = 2000000 / depth;
+		double walk_ns = benchmark::ns_per_op(queries, [&](std::size_t) { benchmark::keep((std::size_t)telescope->uncached_magnification()); });
+		double cached_ns = benchmark::ns_per_op(queries, [&](std::size_t) { benchmark::keep((std::size_t)telescope->magnification()); });
+		std::cout << "  depth " << depth << ": walk " << walk_ns << " ns, cached " << cached_ns << " ns" << std::endl;
+	}
+
 	return 0;
 }
\ No newline at end of file